@@ -0,0 +1,196 @@
+/*
+	Benchmark Harness
+		Minimal microbenchmark runner for the CPU hot paths.
+
+		Every benchmark is warmed up, then the batch size is grown until one
+		sample takes long enough to time reliably. A fixed number of samples
+		is collected and reported as time per iteration: min, median, mean,
+		standard deviation and max. Items per second are added when the
+		benchmark says how many items one iteration processes.
+
+	Usage
+		glt_bench [--filter=substring] [--json=path] [--min-time=seconds] [--samples=n]
+
+		Results go to stdout as JSON (or to --json), a readable table goes to
+		stderr.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "Core/Common.h"
+
+// Keeps the compiler from discarding a value or the work behind it
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	const volatile T* sink = &value;
+	(void)sink;
+#endif
+}
+
+struct BenchResult
+{
+	std::string name;
+	u64 iterations = 0; // Per sample
+	u32 samples = 0;
+	f64 min_ns = 0.0;
+	f64 median_ns = 0.0;
+	f64 mean_ns = 0.0;
+	f64 stddev_ns = 0.0;
+	f64 max_ns = 0.0;
+	f64 items_per_second = 0.0;
+};
+
+class Bench
+{
+public:
+	Bench(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			auto value = [&](const char* prefix) { return arg.substr(std::string(prefix).size()); };
+
+			if      (arg.starts_with("--filter="))   m_filter   = value("--filter=");
+			else if (arg.starts_with("--json="))     m_json     = value("--json=");
+			else if (arg.starts_with("--min-time=")) m_min_time = std::stod(value("--min-time="));
+			else if (arg.starts_with("--samples="))  m_samples  = std::max(1, std::stoi(value("--samples=")));
+			else std::fprintf(stderr, "WARNING: Unknown argument %s\n", arg.c_str());
+		}
+	}
+
+public:
+	// items: work items per call of fn, 0 to skip the throughput column
+	template <typename F>
+	void Run(const std::string& name, F&& fn, u64 items = 0)
+	{
+		if (!m_filter.empty() && name.find(m_filter) == std::string::npos)
+			return;
+
+		using clock = std::chrono::steady_clock;
+		auto seconds = [](clock::duration d) { return std::chrono::duration<f64>(d).count(); };
+
+		// Warmup, caches and branch predictors settle
+		auto start = clock::now();
+		u64 warmup = 0;
+		do { fn(); warmup++; } while (seconds(clock::now() - start) < m_min_time * 0.1 && warmup < 1000000);
+
+		// Grow the batch until one sample takes its share of the time budget
+		f64 target = m_min_time / m_samples;
+		u64 batch = 1;
+		while (true)
+		{
+			start = clock::now();
+			for (u64 i = 0; i < batch; i++)
+				fn();
+			f64 elapsed = seconds(clock::now() - start);
+			if (elapsed >= target || batch >= (1ull << 30))
+				break;
+			batch = elapsed <= 0.0 ? batch * 10 : std::max(batch + 1, static_cast<u64>(batch * target / elapsed * 1.2));
+		}
+
+		std::vector<f64> per_iteration(m_samples);
+		for (u32 s = 0; s < m_samples; s++)
+		{
+			start = clock::now();
+			for (u64 i = 0; i < batch; i++)
+				fn();
+			per_iteration[s] = seconds(clock::now() - start) * 1e9 / batch;
+		}
+
+		BenchResult r;
+		r.name = name;
+		r.iterations = batch;
+		r.samples = m_samples;
+
+		std::sort(per_iteration.begin(), per_iteration.end());
+		size_t n = per_iteration.size();
+		r.min_ns = per_iteration.front();
+		r.max_ns = per_iteration.back();
+		r.median_ns = n % 2 ? per_iteration[n / 2] : 0.5 * (per_iteration[n / 2 - 1] + per_iteration[n / 2]);
+		for (f64 t : per_iteration)
+			r.mean_ns += t;
+		r.mean_ns /= n;
+		for (f64 t : per_iteration)
+			r.stddev_ns += (t - r.mean_ns) * (t - r.mean_ns);
+		r.stddev_ns = n > 1 ? std::sqrt(r.stddev_ns / (n - 1)) : 0.0;
+		if (items > 0)
+			r.items_per_second = items * 1e9 / r.median_ns;
+
+		std::fprintf(stderr, "%-40s %12.1f ns  (min %.1f, +/- %.1f%%)  x%llu",
+			name.c_str(), r.median_ns, r.min_ns, 100.0 * r.stddev_ns / r.mean_ns, (unsigned long long)batch);
+		if (items > 0)
+			std::fprintf(stderr, "  %.3g items/s", r.items_per_second);
+		std::fprintf(stderr, "\n");
+
+		m_results.push_back(r);
+	}
+
+	bool Report() const
+	{
+		FILE* out = m_json.empty() ? stdout : std::fopen(m_json.c_str(), "w");
+		if (!out)
+		{
+			std::fprintf(stderr, "ERROR: Could not open %s\n", m_json.c_str());
+			return false;
+		}
+
+		std::fprintf(out, "{\n  \"context\": {\n");
+		std::fprintf(out, "    \"date\": %lld,\n", (long long)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+		std::fprintf(out, "    \"compiler\": \"%s\",\n", Compiler());
+#ifdef NDEBUG
+		std::fprintf(out, "    \"build\": \"release\",\n");
+#else
+		std::fprintf(out, "    \"build\": \"debug\",\n");
+#endif
+		std::fprintf(out, "    \"min_time\": %g,\n    \"samples\": %u\n  },\n", m_min_time, m_samples);
+
+		std::fprintf(out, "  \"benchmarks\": [\n");
+		for (size_t i = 0; i < m_results.size(); i++)
+		{
+			const BenchResult& r = m_results[i];
+			std::fprintf(out, "    { \"name\": \"%s\", \"iterations\": %llu, \"samples\": %u, "
+				"\"min_ns\": %.3f, \"median_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"max_ns\": %.3f",
+				r.name.c_str(), (unsigned long long)r.iterations, r.samples,
+				r.min_ns, r.median_ns, r.mean_ns, r.stddev_ns, r.max_ns);
+			if (r.items_per_second > 0.0)
+				std::fprintf(out, ", \"items_per_second\": %.6g", r.items_per_second);
+			std::fprintf(out, " }%s\n", i + 1 < m_results.size() ? "," : "");
+		}
+		std::fprintf(out, "  ]\n}\n");
+
+		if (out != stdout)
+			std::fclose(out);
+		return true;
+	}
+
+private:
+	static const char* Compiler()
+	{
+#if defined(__clang__)
+		return "clang " __clang_version__;
+#elif defined(__GNUC__)
+		return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+		return "msvc";
+#else
+		return "unknown";
+#endif
+	}
+
+private:
+	std::string m_filter;
+	std::string m_json;
+	f64 m_min_time = 0.5;
+	u32 m_samples = 20;
+	std::vector<BenchResult> m_results;
+};
@@ -0,0 +1,259 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include "bench.h"
+
+#include "Core/Random.h"
+#include "Graphics/PixelBuffer.h"
+#include "Graphics/Mesh.h"
+#include "FastNoiseLite/FastNoiseLite.h"
+#include "fluid_simulation/fluid_simulation.h"
+#include "audio_reactive/dsp.h"
+#include "audio_reactive/analysis.h"
+
+// Fluid state seeded with a few sources so the solver has work to do
+static FluidModel MakeFluid(s32 size)
+{
+    FluidModel fluid(size, 0.0001f, 0.0001f);
+    Random rng(1);
+    for (s32 i = 0; i < 64; i++)
+    {
+        s32 x = rng.uniformi(1, size - 2);
+        s32 y = rng.uniformi(1, size - 2);
+        fluid.AddDensity(x, y, rng.uniform(50.0f, 200.0f));
+        fluid.AddVelocity(x, y, rng.uniform(-5.0f, 5.0f), rng.uniform(-5.0f, 5.0f));
+    }
+    return fluid;
+}
+
+// Subdivided plane with positions, normals and uvs in the same layout the loader expects
+static std::string WriteObj(s32 subdivisions)
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "glt_bench_mesh.obj";
+    std::ofstream file(path);
+
+    s32 n = subdivisions + 1;
+    for (s32 y = 0; y < n; y++)
+        for (s32 x = 0; x < n; x++)
+            file << "v " << x / f32(subdivisions) << " 0 " << y / f32(subdivisions) << "\n";
+    for (s32 y = 0; y < n; y++)
+        for (s32 x = 0; x < n; x++)
+            file << "vt " << x / f32(subdivisions) << " " << y / f32(subdivisions) << "\n";
+    file << "vn 0 1 0\n";
+
+    for (s32 y = 0; y < subdivisions; y++)
+    {
+        for (s32 x = 0; x < subdivisions; x++)
+        {
+            s32 a = y * n + x + 1, b = a + 1, c = a + n, d = c + 1;
+            file << "f " << a << "/" << a << "/1 " << c << "/" << c << "/1 " << b << "/" << b << "/1\n";
+            file << "f " << b << "/" << b << "/1 " << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+        }
+    }
+
+    return path.string();
+}
+
+int main(int argc, char** argv)
+{
+    Bench bench(argc, argv);
+
+    // Fluid
+    for (s32 size : { 64, 128, 256 })
+    {
+        FluidModel fluid = MakeFluid(size);
+        bench.Run("fluid/simulate/" + std::to_string(size), [&] {
+            fluid.Simulate(0.1f);
+            DoNotOptimize(fluid.density[idx(size / 2, size / 2, size)]);
+        }, u64(size) * size);
+    }
+
+    {
+        const s32 size = 256;
+        FluidModel fluid = MakeFluid(size);
+        f32 dt = 0.1f;
+        f32 a = dt * fluid.diff * (size - 2) * (size - 2);
+
+        bench.Run("fluid/lin_solve/256", [&] {
+            lin_solve(0, fluid.s, fluid.density, a, 1 + 4 * a, 4, size);
+            DoNotOptimize(fluid.s[idx(size / 2, size / 2, size)]);
+        }, u64(size) * size * 4);
+
+        bench.Run("fluid/advect/256", [&] {
+            advect(0, fluid.s, fluid.density, fluid.vx, fluid.vy, dt, size);
+            DoNotOptimize(fluid.s[idx(size / 2, size / 2, size)]);
+        }, u64(size) * size);
+    }
+
+    // Audio analysis
+    {
+        Random rng(2);
+        std::vector<f32> fft = rng.uniform(0.0f, 1.0f, BINS);
+        BandProcessor processor;
+
+        bench.Run("dsp/extract_bands", [&] {
+            Bands bands = extract_bands(fft.data());
+            DoNotOptimize(bands);
+        }, BINS);
+
+        for (s32 size : { 1024, 4096, 65536 })
+        {
+            FFT transform(size);
+            std::vector<f32> input = rng.uniform(-1.0f, 1.0f, size);
+            std::vector<f32> re(transform.Bins()), im(transform.Bins());
+            bench.Run("dsp/fft/" + std::to_string(size), [&] {
+                transform.Forward(input.data(), re.data(), im.data());
+                DoNotOptimize(re[1]);
+            }, size);
+        }
+
+        Filterbank mel(64, 20.0f, 16000.0f, SCALE_MEL, FILTER_TRIANGULAR);
+        std::vector<f32> bands(mel.Bands());
+        bench.Run("dsp/filterbank/mel64", [&] {
+            mel.apply(fft.data(), bands.data());
+            DoNotOptimize(bands[0]);
+        }, BINS);
+
+        Bands raw = extract_bands(fft.data());
+        bench.Run("dsp/band_processor", [&] {
+            Bands motion = processor.update(raw);
+            DoNotOptimize(motion);
+        });
+
+        SpectralFlux flux(MEL_BANDS);
+        std::vector<f32> spectra[2] = { rng.uniform(0.0f, 4.0f, MEL_BANDS), rng.uniform(0.0f, 4.0f, MEL_BANDS) };
+        u32 spectrum = 0;
+        bench.Run("dsp/spectral_flux/mel64", [&] {
+            DoNotOptimize(flux.update(spectra[spectrum++ & 1].data()));
+        }, MEL_BANDS);
+
+        OnsetDetector onsets;
+        TempoTracker tempo;
+        std::vector<f32> novelty = rng.uniform(0.0f, 1.0f, 4096);
+        u32 frame = 0;
+        bench.Run("dsp/onset_detector", [&] {
+            DoNotOptimize(onsets.update(novelty[frame++ & 4095]));
+        });
+        bench.Run("dsp/tempo_tracker", [&] {
+            tempo.update(novelty[frame++ & 4095]);
+            DoNotOptimize(tempo.Phase());
+        });
+
+        FeatureExtractor extractor;
+        std::vector<f32> pcm = rng.uniform(-1.0f, 1.0f, ANALYSIS_HOP);
+        bench.Run("dsp/feature_extractor/hop", [&] {
+            extractor.Push(pcm.data(), ANALYSIS_HOP, [](const AnalysisFrame& frame) { DoNotOptimize(frame.motion); });
+        }, ANALYSIS_HOP);
+
+        for (s32 bands : { 6, 128 })
+        {
+            EnvelopeProcessor envelope(bands);
+            std::vector<f32> input = rng.uniform(0.0f, 4.0f, bands);
+            bench.Run("dsp/envelope/" + std::to_string(bands), [&] {
+                envelope.update(input.data());
+                DoNotOptimize(envelope.Motion()[0]);
+            }, bands);
+        }
+    }
+
+    // Noise
+    {
+        FastNoiseLite noise;
+        noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+        noise.SetFrequency(0.01f);
+
+        const s32 size = 256;
+        bench.Run("noise/opensimplex2/2d", [&] {
+            f32 sum = 0.0f;
+            for (s32 y = 0; y < size; y++)
+                for (s32 x = 0; x < size; x++)
+                    sum += noise.GetNoise(f32(x), f32(y));
+            DoNotOptimize(sum);
+        }, u64(size) * size);
+
+        bench.Run("noise/opensimplex2/3d", [&] {
+            f32 sum = 0.0f;
+            for (s32 y = 0; y < size; y++)
+                for (s32 x = 0; x < size; x++)
+                    sum += noise.GetNoise(f32(x), f32(y), 17.0f);
+            DoNotOptimize(sum);
+        }, u64(size) * size);
+    }
+
+    // Pixels
+    {
+        const s32 width = 512, height = 512;
+        PixelBuffer pixels(width, height);
+
+        bench.Run("pixels/clear/512", [&] {
+            pixels.Clear({ 10, 20, 30, 255 });
+            DoNotOptimize(pixels.m_pixels[0]);
+        }, u64(width) * height);
+
+        bench.Run("pixels/set_pixel/512", [&] {
+            for (s32 y = 0; y < height; y++)
+                for (s32 x = 0; x < width; x++)
+                    pixels.SetPixel(x, y, u8(x), u8(y), u8(x ^ y));
+            DoNotOptimize(pixels.m_pixels[0]);
+        }, u64(width) * height);
+    }
+
+    // Mesh loading
+    {
+        std::string path = WriteObj(64);
+        bench.Run("mesh/load_from_file/64x64", [&] {
+            Mesh mesh;
+            mesh.load_from_file(path);
+            DoNotOptimize(mesh.vertices.size());
+        }, 64 * 64 * 2);
+        std::filesystem::remove(path);
+    }
+
+    // Random
+    {
+        Random rng(3);
+        const u32 count = 65536;
+
+        bench.Run("random/uniform", [&] { DoNotOptimize(rng.uniform(0.0f, 1.0f, count)); }, count);
+        bench.Run("random/uniformi", [&] { DoNotOptimize(rng.uniformi(0, 255, count)); }, count);
+        bench.Run("random/normal", [&] { DoNotOptimize(rng.normal(0.0f, 1.0f, count)); }, count);
+        bench.Run("random/bernoulli", [&] { DoNotOptimize(rng.bernoulli(0.5f, count)); }, count);
+
+        std::vector<f32> floats(count);
+        std::vector<s32> ints(count);
+        std::vector<u8> bytes(count);
+        bench.Run("random/fill_uniform", [&] { rng.fill_uniform(floats, 0.0f, 1.0f); DoNotOptimize(floats[0]); }, count);
+        bench.Run("random/fill_uniformi", [&] { rng.fill_uniformi(ints, 0, 255); DoNotOptimize(ints[0]); }, count);
+        bench.Run("random/fill_normal", [&] { rng.fill_normal(floats, 0.0f, 1.0f); DoNotOptimize(floats[0]); }, count);
+        bench.Run("random/fill_bytes", [&] { rng.fill_bytes(bytes); DoNotOptimize(bytes[0]); }, count);
+
+        // Scalar draws per engine
+        auto scalar = [&](const std::string& name, auto& r) {
+            bench.Run("random/scalar/" + name, [&] {
+                s32 sum = 0;
+                for (u32 i = 0; i < count; i++)
+                    sum += r.uniformi(0, 255);
+                DoNotOptimize(sum);
+            }, count);
+        };
+        Random xoshiro(4);
+        RandomPCG pcg(4);
+        RandomMT mt(4);
+        scalar("xoshiro256pp", xoshiro);
+        scalar("pcg64", pcg);
+        scalar("mt19937", mt);
+
+        CounterRandom philox(4);
+        bench.Run("random/philox/fill_uniform", [&] { philox.fill_uniform(floats, 0.0f, 1.0f); DoNotOptimize(floats[0]); }, count);
+        bench.Run("random/philox/normal2", [&] {
+            vf2 sum = vf2(0.0f);
+            for (u32 i = 0; i < count; i++)
+                sum += philox.normal2(i, vf2(0.0f), vf2(1.0f));
+            DoNotOptimize(sum);
+        }, count);
+    }
+
+    return bench.Report() ? 0 : 1;
+}
@@ -0,0 +1,571 @@
+/*
+	Audio Analysis
+		Spectrum and band analysis off the render thread.
+
+		FeatureExtractor turns a mono sample stream into one AnalysisFrame
+		per hop: STFT magnitude, the six extract_bands bands and their
+		envelopes, a mel spectrum, spectral flux onsets and the tempo
+		tracker's beat phase. Hop based, so smoothing constants mean the
+		same thing at any frame rate. Band and mel edges are placed with
+		the real sample rate, so a 48 kHz stream yields the same bands as
+		a 44.1 kHz one.
+
+		AudioAnalyzer runs it on a worker thread. AnalysisTap is a SoLoud
+		global filter: on the audio thread it mixes the output down to mono
+		and pushes it into an SPSC ring, dropping samples when the ring is
+		full instead of waiting. It also reports the mix sample rate, the
+		worker rebuilds the extractor when that differs. The worker drains the ring and publishes
+		every frame through a triple buffer, the renderer picks up the
+		latest one without blocking. Consumers that need every hop, such as
+		a spectrum history, Drain() a second ring of frames instead.
+
+		soloud.setGlobalFilter(0, &analyzer.Tap());
+		analyzer.Start();
+		...
+		const AnalysisFrame& frame = analyzer.Latest();
+
+	Cache
+		For offline renders the whole track is analyzed up front. The source
+		is decoded through its own instance in chunks of a few thousand
+		hops, so a WavStream never has to be held in memory. Spectra and
+		flux of a chunk are computed in parallel, envelopes, onsets and
+		tempo in one ordered pass after. The frames are written next to
+		the audio file (abyss.wav -> abyss.wav.analysis) as a header and an
+		array of AnalysisFrame, then memory mapped and looked up by time.
+		The source is analyzed at its own base sample rate. The file is
+		rebuilt when the audio file size or time, the hop, the sample rate
+		or the frame layout changes.
+*/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <type_traits>
+#include <cstring>
+
+#include "soloud.h"
+#include "soloud_filter.h"
+
+#include "Core/Common.h"
+#include "Core/SpscRing.h"
+#include "Core/TripleBuffer.h"
+#include "Core/MappedFile.h"
+
+#include "dsp.h"
+
+constexpr s32 ANALYSIS_HOP     = 512; // ~11.6 ms at 44.1 kHz
+constexpr s32 MEL_BANDS        = 64;
+constexpr s32 SPECTRUM_PREVIEW = 128; // Bins kept for display
+
+struct AnalysisFrame
+{
+	u64 hop = 0;     // Hops analyzed so far
+	f64 time = 0.0;  // Seconds of audio analyzed at the end of this hop
+	Bands raw;
+	Bands motion;
+	u32 onsets = 0;  // Bit per band of raw, rising edges of the envelope
+
+	// Onsets and tempo
+	f32 flux = 0.0f;            // Spectral flux novelty
+	f32 bpm = 0.0f;
+	f32 beat_phase = 0.0f;      // [0, 1), 0 on the beat
+	f32 beat_confidence = 0.0f; // [0, 1]
+	u8 onset = 0;               // Flux peak, one hop late
+	u8 beat = 0;                // Beat phase wrapped this hop
+
+	std::array<f32, MEL_BANDS> mel = {};
+	std::array<f32, SPECTRUM_PREVIEW> spectrum = {};
+};
+
+// Analysis state carried from hop to hop
+struct FeatureState
+{
+	BandProcessor bands;
+	OnsetDetector onsets;
+	TempoTracker tempo;
+
+	FeatureState(f32 frame_rate = SAMPLE_RATE / static_cast<f32>(ANALYSIS_HOP)) : onsets(frame_rate), tempo(frame_rate) {}
+};
+
+class FeatureExtractor
+{
+public:
+	FeatureExtractor(s32 hop = ANALYSIS_HOP, f32 sample_rate = SAMPLE_RATE)
+		: m_stft(FFT_SIZE, hop, WINDOW_HANN), m_sample_rate(sample_rate),
+		  m_bands(BandBank(sample_rate)),
+		  m_mel(MelBank(sample_rate)),
+		  m_state(sample_rate / hop),
+		  m_magnitude(m_stft.Bins())
+	{
+	}
+
+public:
+	// fn(const AnalysisFrame&) once per completed hop
+	template <typename F>
+	void Push(const f32* samples, s32 count, F&& fn)
+	{
+		m_stft.Push(samples, count, [&](const f32* re, const f32* im, s32 bins) {
+			magnitude(re, im, m_magnitude.data(), bins);
+
+			m_frame.hop++;
+			m_frame.time = static_cast<f64>(m_frame.hop) * m_stft.Hop() / m_sample_rate;
+			Spectral(m_magnitude.data(), m_bands, m_mel, m_flux, m_frame);
+			Temporal(m_state, m_frame);
+
+			fn(m_frame);
+		});
+	}
+
+	void Reset()
+	{
+		m_stft.Reset();
+		m_flux.Reset();
+		m_state = FeatureState(m_sample_rate / m_stft.Hop());
+		m_frame = AnalysisFrame();
+	}
+
+	s32 Hop() const { return m_stft.Hop(); }
+	f32 SampleRate() const { return m_sample_rate; }
+
+	// Per hop features that only depend on this and the previous hop's spectrum
+	static void Spectral(const f32* magnitude, const Filterbank& bands, const Filterbank& mel, SpectralFlux& flux, AnalysisFrame& frame)
+	{
+		frame.raw = extract_bands(magnitude, bands);
+		mel.apply(magnitude, frame.mel.data());
+		frame.flux = flux.update(frame.mel.data());
+		std::copy_n(magnitude, SPECTRUM_PREVIEW, frame.spectrum.begin());
+	}
+
+	// Features that carry state from hop to hop, must run in order
+	static void Temporal(FeatureState& state, AnalysisFrame& frame)
+	{
+		frame.motion = state.bands.update(frame.raw);
+		frame.onsets = 0;
+		for (s32 b = 0; b < state.bands.envelope.Bands(); b++)
+			frame.onsets |= static_cast<u32>(state.bands.envelope.Onsets()[b]) << b;
+
+		frame.onset = state.onsets.update(frame.flux);
+		state.tempo.update(frame.flux);
+		frame.bpm = state.tempo.Bpm();
+		frame.beat_phase = state.tempo.Phase();
+		frame.beat_confidence = state.tempo.Confidence();
+		frame.beat = state.tempo.Beat();
+	}
+
+	static Filterbank BandBank(f32 sample_rate) { return band_filterbank(sample_rate / FFT_SIZE); }
+
+	// Stops at Nyquist for low sample rates
+	static Filterbank MelBank(f32 sample_rate)
+	{
+		f32 max_freq = std::min(16000.0f, 0.5f * sample_rate);
+		return Filterbank(MEL_BANDS, 20.0f, max_freq, SCALE_MEL, FILTER_TRIANGULAR, BINS, sample_rate / FFT_SIZE);
+	}
+
+private:
+	STFT m_stft;
+	f32 m_sample_rate;
+	Filterbank m_bands;
+	Filterbank m_mel;
+	SpectralFlux m_flux = SpectralFlux(MEL_BANDS);
+	FeatureState m_state;
+	std::vector<f32> m_magnitude;
+	AnalysisFrame m_frame;
+};
+
+// Audio thread side, mixes down to mono and pushes into the ring
+class AnalysisTapInstance : public SoLoud::FilterInstance
+{
+public:
+	AnalysisTapInstance(SpscRing<f32>& ring, std::atomic<u64>& dropped, std::atomic<f32>& sample_rate)
+		: m_ring(ring), m_dropped(dropped), m_sample_rate(sample_rate) {}
+
+	void filter(float* buffer, unsigned int samples, unsigned int channels, float samplerate, SoLoud::time time) override
+	{
+		// Published before the samples, the worker reads it after popping them
+		m_sample_rate.store(samplerate, std::memory_order_relaxed);
+
+		// Planar, channel c starts at buffer + c * samples
+		constexpr unsigned int CHUNK = 256;
+		f32 mono[CHUNK];
+		f32 gain = 1.0f / channels;
+
+		for (unsigned int offset = 0; offset < samples; offset += CHUNK)
+		{
+			unsigned int n = std::min(CHUNK, samples - offset);
+			for (unsigned int i = 0; i < n; i++)
+			{
+				f32 sum = 0.0f;
+				for (unsigned int c = 0; c < channels; c++)
+					sum += buffer[c * samples + offset + i];
+				mono[i] = sum * gain;
+			}
+
+			size_t pushed = m_ring.Push(mono, n);
+			if (pushed < n)
+				m_dropped.fetch_add(n - pushed, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	SpscRing<f32>& m_ring;
+	std::atomic<u64>& m_dropped;
+	std::atomic<f32>& m_sample_rate;
+};
+
+class AnalysisTap : public SoLoud::Filter
+{
+public:
+	AnalysisTap(SpscRing<f32>& ring, std::atomic<u64>& dropped, std::atomic<f32>& sample_rate)
+		: m_ring(ring), m_dropped(dropped), m_sample_rate(sample_rate) {}
+
+	SoLoud::FilterInstance* createInstance() override
+	{
+		return new AnalysisTapInstance(m_ring, m_dropped, m_sample_rate);
+	}
+
+private:
+	SpscRing<f32>& m_ring;
+	std::atomic<u64>& m_dropped;
+	std::atomic<f32>& m_sample_rate;
+};
+
+class AudioAnalyzer
+{
+public:
+	AudioAnalyzer(s32 hop = ANALYSIS_HOP) : m_ring(1 << 16), m_tap(m_ring, m_dropped, m_sample_rate), m_extractor(hop), m_history(256) {}
+	~AudioAnalyzer() { Stop(); }
+
+	AudioAnalyzer(const AudioAnalyzer&) = delete;
+	AudioAnalyzer& operator=(const AudioAnalyzer&) = delete;
+
+public:
+	SoLoud::Filter& Tap() { return m_tap; }
+
+	void Start()
+	{
+		if (m_running.exchange(true))
+			return;
+		m_worker = std::thread(&AudioAnalyzer::Run, this);
+	}
+
+	// Detach the tap or stop the audio engine first
+	void Stop()
+	{
+		if (!m_running.exchange(false))
+			return;
+		if (m_worker.joinable())
+			m_worker.join();
+	}
+
+	// Render thread, never blocks
+	const AnalysisFrame& Latest()
+	{
+		m_frames.Update();
+		return m_frames.Front();
+	}
+
+	// Render thread, fn(const AnalysisFrame&) for every frame since the last call,
+	// oldest first. Frames are dropped while nobody drains for ~3 s.
+	template <typename F>
+	void Drain(F&& fn)
+	{
+		AnalysisFrame frame;
+		while (m_history.Pop(&frame, 1) == 1)
+			fn(frame);
+	}
+
+	u64 Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+	void Run()
+	{
+		constexpr size_t BLOCK = 1024;
+		f32 block[BLOCK];
+
+		while (m_running.load(std::memory_order_relaxed))
+		{
+			size_t n = m_ring.Pop(block, BLOCK);
+			if (n == 0)
+			{
+				// Less than a hop arrives per millisecond
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			// The mix rate is only known once the tap ran, the extractor starts at SAMPLE_RATE
+			f32 sample_rate = m_sample_rate.load(std::memory_order_relaxed);
+			if (sample_rate > 0.0f && sample_rate != m_extractor.SampleRate())
+				m_extractor = FeatureExtractor(m_extractor.Hop(), sample_rate);
+
+			m_extractor.Push(block, static_cast<s32>(n), [this](const AnalysisFrame& frame) {
+				m_frames.Back() = frame;
+				m_frames.Publish();
+				m_history.Push(&frame, 1);
+			});
+		}
+	}
+
+private:
+	SpscRing<f32> m_ring;
+	std::atomic<u64> m_dropped = 0;
+	std::atomic<f32> m_sample_rate = 0.0f;
+	AnalysisTap m_tap;
+
+	FeatureExtractor m_extractor;
+	TripleBuffer<AnalysisFrame> m_frames;
+	SpscRing<AnalysisFrame> m_history;
+
+	std::thread m_worker;
+	std::atomic<bool> m_running = false;
+};
+
+class AnalysisCache
+{
+public:
+	struct Header
+	{
+		char magic[4] = { 'G', 'L', 'T', 'A' };
+		u32 version = VERSION;
+		u32 frame_size = sizeof(AnalysisFrame);
+		u32 hop = 0;
+		f32 sample_rate = 0.0f;
+		u32 frame_count = 0;
+		u64 source_size = 0;
+		s64 source_time = 0;
+	};
+
+	static constexpr u32 VERSION = 3;
+	static_assert(std::is_trivially_copyable_v<AnalysisFrame>, "AnalysisFrame is stored as raw bytes");
+	static_assert(sizeof(Header) % alignof(AnalysisFrame) == 0, "Frames must stay aligned after the header");
+
+public:
+	// Maps audio_path.analysis, analyzing the source first when missing or stale.
+	// Works on Wav and WavStream alike, the source is decoded through its own instance.
+	bool Open(const std::string& audio_path, SoLoud::AudioSource& source, s32 hop = ANALYSIS_HOP)
+	{
+		std::string path = audio_path + ".analysis";
+		Header expected = Describe(audio_path, source, hop);
+
+		if (!Map(path, expected))
+		{
+			auto start = std::chrono::steady_clock::now();
+			if (!Build(path, source, expected))
+				return false;
+			f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+			std::printf("INFO: Analyzed %s, %u frames in %.2f s\n", audio_path.c_str(), expected.frame_count, seconds);
+
+			if (!Map(path, expected))
+			{
+				std::printf("ERROR: Could not load %s\n", path.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Frame analyzed up to time, an empty frame before the first hop
+	const AnalysisFrame& At(f64 time) const
+	{
+		static const AnalysisFrame empty;
+		if (m_count == 0)
+			return empty;
+
+		s64 index = static_cast<s64>(time * m_header.sample_rate / m_header.hop) - 1;
+		if (index < 0)
+			return empty;
+		return m_frames[std::min<s64>(index, m_count - 1)];
+	}
+
+	// Frame of hop index + 1, Count() must not be 0
+	const AnalysisFrame& Frame(u32 index) const { return m_frames[std::min(index, m_count - 1)]; }
+
+	u32 Count() const { return m_count; }
+	f64 Duration() const { return m_count == 0 ? 0.0 : static_cast<f64>(m_count) * m_header.hop / m_header.sample_rate; }
+
+private:
+	// Frame count is only known once decoded, the source file identifies the track
+	static Header Describe(const std::string& audio_path, const SoLoud::AudioSource& source, s32 hop)
+	{
+		Header h;
+		h.hop = hop;
+		h.sample_rate = source.mBaseSamplerate;
+
+		std::error_code error;
+		h.source_size = std::filesystem::file_size(audio_path, error);
+		auto time = std::filesystem::last_write_time(audio_path, error);
+		h.source_time = error ? 0 : static_cast<s64>(time.time_since_epoch().count());
+		return h;
+	}
+
+	bool Map(const std::string& path, const Header& expected)
+	{
+		m_frames = nullptr;
+		m_count = 0;
+		if (!m_file.Open(path))
+			return false;
+
+		Header h;
+		if (m_file.Size() < sizeof(Header))
+		{
+			m_file.Close();
+			return false;
+		}
+		std::memcpy(&h, m_file.Data(), sizeof(Header));
+
+		bool valid = std::memcmp(h.magic, expected.magic, 4) == 0 && h.version == expected.version &&
+			h.frame_size == expected.frame_size && h.hop == expected.hop && h.sample_rate == expected.sample_rate &&
+			h.source_size == expected.source_size && h.source_time == expected.source_time && h.frame_count > 0 &&
+			m_file.Size() >= sizeof(Header) + static_cast<size_t>(h.frame_count) * sizeof(AnalysisFrame);
+		if (!valid)
+		{
+			m_file.Close();
+			return false;
+		}
+
+		m_header = h;
+		m_frames = reinterpret_cast<const AnalysisFrame*>(m_file.Data() + sizeof(Header));
+		m_count = h.frame_count;
+		return true;
+	}
+
+	// Decodes and analyzes CHUNK_HOPS hops at a time, memory does not grow with the track
+	static bool Build(const std::string& path, SoLoud::AudioSource& source, Header& header)
+	{
+		constexpr u32 CHUNK_HOPS = 2048;
+		constexpr u32 DECODE_BLOCK = 4096;
+
+		s32 hop = static_cast<s32>(header.hop);
+		u32 channels = std::max(1u, source.mChannels);
+		if (hop <= 0 || hop > FFT_SIZE)
+			return false;
+
+		std::unique_ptr<SoLoud::AudioSourceInstance> instance(source.createInstance());
+		if (!instance)
+			return false;
+		instance->init(source, 0);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::printf("ERROR: Could not write %s\n", path.c_str());
+			return false;
+		}
+		header.frame_count = 0;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+		// Mono samples from FFT_SIZE before the chunk's first hop, zeros before the track
+		std::vector<f32> mono(FFT_SIZE + static_cast<size_t>(CHUNK_HOPS) * hop, 0.0f);
+		std::vector<f32> planar(static_cast<size_t>(DECODE_BLOCK) * channels);
+		std::vector<AnalysisFrame> frames(CHUNK_HOPS);
+		FeatureState state(header.sample_rate / hop);
+
+		u32 workers = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::thread> threads;
+		bool ended = false;
+
+		while (!ended)
+		{
+			// Decode, planar blocks mixed down as in the tap
+			size_t filled = FFT_SIZE;
+			while (filled < mono.size() && !ended)
+			{
+				u32 want = static_cast<u32>(std::min<size_t>(DECODE_BLOCK, mono.size() - filled));
+				u32 got = instance->getAudio(planar.data(), want, want);
+				f32 gain = 1.0f / channels;
+				for (u32 i = 0; i < got; i++)
+				{
+					f32 sum = 0.0f;
+					for (u32 c = 0; c < channels; c++)
+						sum += planar[c * want + i];
+					mono[filled + i] = sum * gain;
+				}
+				filled += got;
+				ended = got < want || instance->hasEnded();
+			}
+
+			u32 hops = static_cast<u32>((filled - FFT_SIZE) / hop);
+			if (hops == 0)
+				break;
+
+			// Hop j of the chunk sees the FFT_SIZE samples ending at FFT_SIZE + (j + 1) * hop
+			u32 first_hop = header.frame_count;
+			auto analyze = [&](u32 first, u32 last) {
+				FFT fft(FFT_SIZE);
+				Filterbank bands = FeatureExtractor::BandBank(header.sample_rate);
+				Filterbank mel = FeatureExtractor::MelBank(header.sample_rate);
+				std::vector<f32> window = make_window(WINDOW_HANN, FFT_SIZE);
+				SpectralFlux flux(MEL_BANDS);
+				std::vector<f32> block(FFT_SIZE), re(fft.Bins()), im(fft.Bins()), mag(fft.Bins());
+
+				auto spectrum = [&](s32 j) {
+					const f32* samples = mono.data() + (j + 1) * hop;
+					for (s32 i = 0; i < FFT_SIZE; i++)
+						block[i] = samples[i] * window[i];
+
+					fft.Forward(block.data(), re.data(), im.data());
+					magnitude(re.data(), im.data(), mag.data(), fft.Bins());
+				};
+
+				// Flux needs the hop before the worker's first, zeros before the track
+				if (first_hop + first > 0)
+				{
+					AnalysisFrame previous;
+					spectrum(static_cast<s32>(first) - 1);
+					FeatureExtractor::Spectral(mag.data(), bands, mel, flux, previous);
+				}
+
+				for (u32 j = first; j < last; j++)
+				{
+					spectrum(j);
+
+					AnalysisFrame& frame = frames[j];
+					frame.hop = first_hop + j + 1;
+					frame.time = static_cast<f64>(frame.hop) * hop / header.sample_rate;
+					FeatureExtractor::Spectral(mag.data(), bands, mel, flux, frame);
+				}
+			};
+
+			u32 per_worker = (hops + workers - 1) / workers;
+			for (u32 w = 0; w < workers; w++)
+			{
+				u32 first = w * per_worker;
+				u32 last = std::min(hops, first + per_worker);
+				if (first < last)
+					threads.emplace_back(analyze, first, last);
+			}
+			for (std::thread& t : threads)
+				t.join();
+			threads.clear();
+
+			for (u32 j = 0; j < hops; j++)
+				FeatureExtractor::Temporal(state, frames[j]);
+
+			file.write(reinterpret_cast<const char*>(frames.data()), static_cast<size_t>(hops) * sizeof(AnalysisFrame));
+			header.frame_count += hops;
+
+			// Keep the window in front of the next chunk's first hop
+			size_t consumed = static_cast<size_t>(hops) * hop;
+			std::copy(mono.begin() + consumed, mono.begin() + consumed + FFT_SIZE, mono.begin());
+		}
+
+		if (header.frame_count == 0)
+			return false;
+
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		return file.good();
+	}
+
+private:
+	MappedFile m_file;
+	Header m_header;
+	const AnalysisFrame* m_frames = nullptr;
+	u32 m_count = 0;
+};
@@ -1,9 +1,10 @@
 /*
 		Audio Reactive Visualization: Waveforms
-			1. Load .wav
+			1. Stream .wav
 			2. FFT
 			3. Band Split
-			4. 3D audio reactive waveform
+			4. Height field pass, one texel per grid vertex
+			5. 3D audio reactive waveform
 */
 #include "Application.h"
 
@@ -12,11 +13,14 @@
 
 #include "Graphics/Mesh.h"
 #include "Graphics/Camera.h"
+#include "Graphics/RenderTarget.h"
+#include "Graphics/HistoryTexture.h"
 
 #include "soloud.h"
-#include "soloud_wav.h"
+#include "soloud_wavstream.h"
 
 #include "dsp.h"
+#include "analysis.h"
 
 class AudioReactive : public Application
 {
@@ -27,12 +31,25 @@ public:
 	std::unique_ptr<Shader> prisma_shader;
 	std::unique_ptr<Sprite> sprite;
 	vf2 screen_size;
-	f32 time = 0.0f;
 
 	// Grid
-	std::unique_ptr<Shader> grid_shader;
+	static constexpr s32 GRID_COLUMNS = 256;
+	static constexpr s32 GRID_ROWS    = 192;
+	static constexpr f32 GRID_SPACING = 0.25f;
+	std::shared_ptr<Shader> grid_shader;
 	std::unique_ptr<Grid> grid;
 
+	// Heights and normals, evaluated once per vertex per frame
+	std::shared_ptr<Shader> height_shader;
+	std::unique_ptr<RenderTarget> height_field;
+	std::unique_ptr<Quad> quad;
+
+	// Mel spectrum of the last SPECTRUM_HISTORY hops, one row per hop
+	static constexpr s32 SPECTRUM_HISTORY = 256;
+	std::unique_ptr<HistoryTexture> spectrum_history;
+	u64 history_hop = 0;
+	f32 waterfall = 0.0f;
+
 	// Camera
 	Camera camera;
 	vf2 prev_mouse;
@@ -47,13 +64,20 @@ public:
 	vf2 mouse_pos_transformed = { 0.0f,0.0f };
 	vf2 prev_mouse_pos_transformed = { 0.0f,0.0f };
 
+	// Analysis runs on its own thread, declared before the engine so the
+	// tap outlives it
+	AudioAnalyzer analyzer;
+
+	// Offline renders read the precomputed track at the simulated time
+	AnalysisCache cache;
+	f64 offline_time = 0.0;
+
 	// SoLoud engine
 	SoLoud::Soloud soloud;
-	SoLoud::Wav wave;
-	int music_handle;
+	// Decoded while playing, memory and startup do not grow with the track
+	SoLoud::WavStream wave;
+	int music_handle = 0;
 	float* wav;
-	float* fft;
-	BandProcessor processor;
 
 	vf3 movement;
 	vf4 color = { 1.0f, 0.05f, 0.05f, 0.12f };
@@ -65,12 +89,22 @@ public:
 	{
 		screen_size = { m_window.Width(), m_window.Height() };
 		// Grid
-		grid = std::make_unique<Grid>(256, 192, 0.25);
-		grid_shader = std::make_unique<Shader>("res/shaders/audio_reactive/grid.vs", "res/shaders/audio_reactive/grid.fs");
+		grid = std::make_unique<Grid>(GRID_COLUMNS, GRID_ROWS, GRID_SPACING, true);
+		grid_shader = m_shaders.Load("grid", "res/shaders/audio_reactive/grid.vs", "res/shaders/audio_reactive/grid.fs");
+
+		// Height field
+		height_field = std::make_unique<RenderTarget>(GRID_COLUMNS, GRID_ROWS, GL_RGBA32F);
+		height_shader = m_shaders.Load("height_field", "res/shaders/post_processing/post_processing.vs", "res/shaders/audio_reactive/height_field.fs");
+		quad = std::make_unique<Quad>();
+		spectrum_history = std::make_unique<HistoryTexture>(MEL_BANDS, SPECTRUM_HISTORY);
 
 		// Init soloud
 		soloud.init(SoLoud::Soloud::ENABLE_VISUALIZATION);
+		soloud.setGlobalFilter(0, &analyzer.Tap());
+		analyzer.Start();
 		wave.load("res/audio/abyss.wav");
+		if (s_offline.enabled)
+			cache.Open("res/audio/abyss.wav", wave);
 
 		// Camera
 		//vf3 eye    = { 31.0f, 32.0f, 30.0f };
@@ -197,7 +231,9 @@ public:
 
 	void Simulate(f32 dt) override
 	{
-		time += dt;
+		if (s_offline.enabled)
+			offline_time += dt;
+
 		// Movement
 		if (glm::length(movement) > 0.0f)
 		{
@@ -205,39 +241,78 @@ public:
 			camera.translate(velocity * dt);
 			movement = { 0.0f, 0.0f, 0.0f };
 		}
+
+		// Frame uniforms
+		m_frame.proj_view  = camera.proj_camera();
+		m_frame.view       = camera.view();
+		m_frame.projection = camera.projection();
+		m_frame.camera     = vf4(camera.eye(), 1.0f);
 	}
 
 	void Render() override
 	{
-		m_window.Clear();
-
 		// Audio Processing
 		wav = soloud.getWave();
-		fft = soloud.calcFFT();
-		Bands raw    = extract_bands(fft);
-		Bands motion = processor.update(raw);
+		const AnalysisFrame& frame = s_offline.enabled ? cache.At(offline_time) : analyzer.Latest();
+		const Bands& motion = frame.motion;
 		vf3 audio_uniform = { compress(motion.low()), compress(motion.medium()), compress(motion.treble()) };
 
-		// Shader
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+		// Spectrum history, the rows of every hop since the last frame
+		if (s_offline.enabled)
+		{
+			u64 first = std::max<u64>(history_hop, frame.hop > SPECTRUM_HISTORY ? frame.hop - SPECTRUM_HISTORY : 0);
+			for (u64 hop = first + 1; hop <= frame.hop; hop++)
+				spectrum_history->Push(cache.Frame(static_cast<u32>(hop - 1)).mel.data());
+		}
+		else
+		{
+			analyzer.Drain([&](const AnalysisFrame& f) { spectrum_history->Push(f.mel.data()); });
+		}
+		history_hop = frame.hop;
+
+		// Height field, the alpha channel holds the height so nothing may blend
+		f32 width  = (GRID_COLUMNS - 1) * GRID_SPACING;
+		f32 height = (GRID_ROWS - 1) * GRID_SPACING;
+		RenderState::Disable(GL_BLEND);
+		RenderState::Disable(GL_DEPTH_TEST);
+		height_field->Bind();
+		height_shader->Use();
+		height_shader->SetUniform("audio", audio_uniform);
+		height_shader->SetUniform("beat", vf2(frame.beat_phase, frame.beat_confidence));
+		height_shader->SetUniform("extent", vf4(-0.5f * width, -0.5f * height, GRID_SPACING, GRID_SPACING));
+		height_shader->SetUniform("history", 1);
+		height_shader->SetUniform("history_newest", spectrum_history->Newest());
+		height_shader->SetUniform("waterfall", waterfall);
+		spectrum_history->Bind(1);
+		quad->draw(GL_TRIANGLES);
+
+		RenderState::BindFramebuffer(0);
+		glViewport(0, 0, m_window.Width(), m_window.Height());
+		RenderState::Enable(GL_DEPTH_TEST);
+		m_window.Clear();
+
+		// Grid, each edge once from the line list
+		RenderState::Enable(GL_BLEND);
+		RenderState::BlendFunc(GL_SRC_ALPHA, GL_ONE);
 
 		grid_shader->Use();
-		grid_shader->SetUniform("proj_view", camera.proj_camera());
-		grid_shader->SetUniform("t", time);
-		grid_shader->SetUniform("audio", audio_uniform);
+		grid_shader->SetUniform("height_field", 0);
 		grid_shader->SetUniform("col", color);
+		RenderState::BindTexture(0, height_field->texture);
 		grid->draw(GL_LINES);
 
 		m_gui.m_func = [&]() {
 			ImGui::Begin("Output");
 			ImGui::PlotLines("##Wave", wav, 256, 0, "Wave", -1, 1, ImVec2(264, 80));
-			ImGui::PlotHistogram("##FFT", fft, 256 / 2, 0, "FFT", 0, 10, ImVec2(264, 80), 8);
+			ImGui::PlotHistogram("##FFT", frame.spectrum.data(), SPECTRUM_PREVIEW, 0, "FFT", 0, 10, ImVec2(264, 80), 8);
+			ImGui::PlotHistogram("##Mel", frame.mel.data(), MEL_BANDS, 0, "Mel", 0, 10, ImVec2(264, 80));
+			ImGui::Text("Analysis: %.2f s, %llu dropped samples", frame.time, (unsigned long long)analyzer.Dropped());
 			ImGui::Text("Audio (L/M/H): %.3f %.3f %.3f", audio_uniform.x, audio_uniform.y, audio_uniform.z);
+			ImGui::Text("Tempo: %.1f bpm, phase %.2f, confidence %.2f", frame.bpm, frame.beat_phase, frame.beat_confidence);
 			ImGui::Text("Eye:    x=%.3f y=%.3f z=%.3f", camera.eye().x, camera.eye().y, camera.eye().z);
 			ImGui::Text("Up:     x=%.3f y=%.3f z=%.3f", camera.up().x, camera.up().y, camera.up().z);
 			ImGui::Text("Pitch: %.1f  Yaw: %.1f", camera.pitch(), camera.yaw());
+			ImGui::SliderFloat("Waterfall", &waterfall, 0.0f, 1.0f);
 			ImGui::SliderFloat4("R=%.1f G=%.1f B=%.1f A=%.1f", glm::value_ptr(color), 0.0f, 1.0f);
 			ImGui::End();
 		};
@@ -245,7 +320,9 @@ public:
 
 	void Destroy() override
 	{
+		// No more taps after deinit, then the worker can go
 		soloud.deinit();
+		analyzer.Stop();
 	}
 };
 
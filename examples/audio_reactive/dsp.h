@@ -2,6 +2,9 @@
 #include "Core/Common.h"
 
 #include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstdio>
 
 #undef min
 #undef max
@@ -22,6 +25,251 @@ constexpr s32 MID_END      = (s32)(2000 / FREQ_PER_BIN); // ~93  - Mid
 constexpr s32 HIGH_MID_END = (s32)(4000 / FREQ_PER_BIN); // ~186 - High mid
 constexpr s32 HIGH_END     = (s32)(8000 / FREQ_PER_BIN); // ~372 - High
 
+// Window functions
+enum WindowType
+{
+	WINDOW_RECTANGULAR,
+	WINDOW_HANN,
+	WINDOW_HAMMING,
+	WINDOW_BLACKMAN
+};
+
+std::vector<f32> make_window(WindowType type, s32 size)
+{
+	std::vector<f32> w(size, 1.0f);
+	f64 step = 2.0 * 3.14159265358979323846 / size; // periodic, sums evenly under overlap
+	for (s32 i = 0; i < size; i++)
+	{
+		f64 c1 = std::cos(step * i);
+		f64 c2 = std::cos(step * 2.0 * i);
+		switch (type)
+		{
+		case WINDOW_HANN:     w[i] = static_cast<f32>(0.5 - 0.5 * c1); break;
+		case WINDOW_HAMMING:  w[i] = static_cast<f32>(0.54 - 0.46 * c1); break;
+		case WINDOW_BLACKMAN: w[i] = static_cast<f32>(0.42 - 0.5 * c1 + 0.08 * c2); break;
+		default: break;
+		}
+	}
+	return w;
+}
+
+/*
+	Real FFT
+		Forward transform of size power of two real samples (2 .. 65536)
+		into size / 2 + 1 complex bins. The samples are packed as a half
+		size complex sequence, transformed with a radix-2 Stockham FFT and
+		split into the real spectrum in a final pass.
+		Stockham is out of place with contiguous inner loops over split
+		re / im arrays, the compiler vectorizes them. Twiddles are computed
+		once per stage at construction.
+*/
+class FFT
+{
+public:
+	FFT(s32 size = FFT_SIZE) : m_size(size), m_half(size / 2)
+	{
+		if (size < 2 || size > 65536 || (size & (size - 1)) != 0)
+			std::printf("ERROR: FFT size %d must be a power of two in [2, 65536]\n", size);
+
+		const f64 pi = 3.14159265358979323846;
+
+		// Stage twiddles, exp(-i 2pi p / n) for p < n / 2, n = half .. 2
+		for (s32 n = m_half; n > 1; n /= 2)
+		{
+			for (s32 p = 0; p < n / 2; p++)
+			{
+				m_stage_re.push_back(static_cast<f32>(std::cos(2.0 * pi * p / n)));
+				m_stage_im.push_back(static_cast<f32>(-std::sin(2.0 * pi * p / n)));
+			}
+		}
+
+		// Split twiddles, exp(-i 2pi k / size)
+		m_split_re.resize(m_half);
+		m_split_im.resize(m_half);
+		for (s32 k = 0; k < m_half; k++)
+		{
+			m_split_re[k] = static_cast<f32>(std::cos(2.0 * pi * k / size));
+			m_split_im[k] = static_cast<f32>(-std::sin(2.0 * pi * k / size));
+		}
+
+		for (s32 i = 0; i < 2; i++)
+		{
+			m_re[i].resize(m_half);
+			m_im[i].resize(m_half);
+		}
+	}
+
+public:
+	s32 Size() const { return m_size; }
+	s32 Bins() const { return m_half + 1; }
+
+	// input: Size() samples, re / im: Bins() values each
+	void Forward(const f32* input, f32* re, f32* im)
+	{
+		f32* zr = m_re[0].data();
+		f32* zi = m_im[0].data();
+		for (s32 n = 0; n < m_half; n++)
+		{
+			zr[n] = input[2 * n];
+			zi[n] = input[2 * n + 1];
+		}
+
+		s32 result = Transform();
+		zr = m_re[result].data();
+		zi = m_im[result].data();
+
+		// Split the half size spectrum Z into the real spectrum X
+		//   X[k] = E[k] + W^k O[k], E and O the spectra of even and odd samples
+		re[0] = zr[0] + zi[0];
+		im[0] = 0.0f;
+		re[m_half] = zr[0] - zi[0];
+		im[m_half] = 0.0f;
+		for (s32 k = 1; k < m_half; k++)
+		{
+			f32 a = zr[k], b = zi[k];
+			f32 c = zr[m_half - k], d = zi[m_half - k];
+
+			f32 er = 0.5f * (a + c), ei = 0.5f * (b - d);
+			f32 or_ = 0.5f * (b + d), oi = -0.5f * (a - c);
+			f32 wr = m_split_re[k], wi = m_split_im[k];
+
+			re[k] = er + or_ * wr - oi * wi;
+			im[k] = ei + or_ * wi + oi * wr;
+		}
+	}
+
+private:
+	// In place over m_re / m_im ping pong, returns the buffer holding the result
+	s32 Transform()
+	{
+		s32 src = 0;
+		s32 offset = 0;
+		for (s32 n = m_half, s = 1; n > 1; n /= 2, s *= 2)
+		{
+			s32 m = n / 2;
+			const f32* xr = m_re[src].data();
+			const f32* xi = m_im[src].data();
+			f32* yr = m_re[src ^ 1].data();
+			f32* yi = m_im[src ^ 1].data();
+			const f32* tw_re = &m_stage_re[offset];
+			const f32* tw_im = &m_stage_im[offset];
+
+			for (s32 p = 0; p < m; p++)
+			{
+				f32 wr = tw_re[p], wi = tw_im[p];
+				const f32* ar = xr + s * p;
+				const f32* ai = xi + s * p;
+				const f32* br = xr + s * (p + m);
+				const f32* bi = xi + s * (p + m);
+				f32* y0r = yr + s * 2 * p;
+				f32* y0i = yi + s * 2 * p;
+				f32* y1r = yr + s * (2 * p + 1);
+				f32* y1i = yi + s * (2 * p + 1);
+
+				for (s32 q = 0; q < s; q++)
+				{
+					f32 tr = ar[q] - br[q];
+					f32 ti = ai[q] - bi[q];
+					y0r[q] = ar[q] + br[q];
+					y0i[q] = ai[q] + bi[q];
+					y1r[q] = tr * wr - ti * wi;
+					y1i[q] = tr * wi + ti * wr;
+				}
+			}
+
+			offset += m;
+			src ^= 1;
+		}
+		return src;
+	}
+
+private:
+	s32 m_size;
+	s32 m_half;
+	std::vector<f32> m_stage_re, m_stage_im;
+	std::vector<f32> m_split_re, m_split_im;
+	std::vector<f32> m_re[2], m_im[2];
+};
+
+// |X[k]| * scale
+void magnitude(const f32* re, const f32* im, f32* out, s32 bins, f32 scale = 1.0f)
+{
+	for (s32 k = 0; k < bins; k++)
+		out[k] = std::sqrt(re[k] * re[k] + im[k] * im[k]) * scale;
+}
+
+// |X[k]|^2 * scale
+void power(const f32* re, const f32* im, f32* out, s32 bins, f32 scale = 1.0f)
+{
+	for (s32 k = 0; k < bins; k++)
+		out[k] = (re[k] * re[k] + im[k] * im[k]) * scale;
+}
+
+/*
+	STFT
+		Short time analysis over a continuous sample stream. Samples are
+		pushed in any block size; every hop samples the last size samples
+		are windowed and transformed, overlapping by size - hop. Hann at
+		hop = size / 2 or size / 4 sums to a constant under overlap-add.
+*/
+class STFT
+{
+public:
+	STFT(s32 size = FFT_SIZE, s32 hop = FFT_SIZE / 4, WindowType window = WINDOW_HANN)
+		: m_fft(size), m_hop(hop), m_window(make_window(window, size))
+	{
+		m_history.resize(size, 0.0f);
+		m_frame.resize(size);
+		m_re.resize(m_fft.Bins());
+		m_im.resize(m_fft.Bins());
+	}
+
+public:
+	// fn(re, im, bins) runs once per completed hop
+	template <typename F>
+	void Push(const f32* samples, s32 count, F&& fn)
+	{
+		s32 size = m_fft.Size();
+		for (s32 i = 0; i < count; i++)
+		{
+			m_history[m_write] = samples[i];
+			m_write = (m_write + 1) % size;
+
+			if (++m_pending < m_hop)
+				continue;
+			m_pending = 0;
+
+			// Oldest sample first
+			for (s32 j = 0; j < size; j++)
+				m_frame[j] = m_history[(m_write + j) % size] * m_window[j];
+
+			m_fft.Forward(m_frame.data(), m_re.data(), m_im.data());
+			fn(m_re.data(), m_im.data(), m_fft.Bins());
+		}
+	}
+
+	void Reset()
+	{
+		std::fill(m_history.begin(), m_history.end(), 0.0f);
+		m_write = 0;
+		m_pending = 0;
+	}
+
+	s32 Size() const { return m_fft.Size(); }
+	s32 Hop() const { return m_hop; }
+	s32 Bins() const { return m_fft.Bins(); }
+
+private:
+	FFT m_fft;
+	s32 m_hop;
+	std::vector<f32> m_window;
+	std::vector<f32> m_history;
+	std::vector<f32> m_frame;
+	std::vector<f32> m_re, m_im;
+	s32 m_write = 0;
+	s32 m_pending = 0;
+};
+
 struct Bands
 {
 	f32 sub_bass = 0.0f;
@@ -40,41 +288,196 @@ struct Mel { f32 min, max; };
 f32 freq_to_mel(f32 freq) { return 2595.0f * log10(1.0f + freq / 700.0f); }
 f32 mel_to_freq(f32 mel)  { return 700.0f * (pow(10.0f, mel / 2595.0f) - 1.0f); }
 
-Bands extract_bands(const f32* fft)
+// Bark scale, Traunmueller's approximation
+f32 freq_to_bark(f32 freq) { return 26.81f * freq / (1960.0f + freq) - 0.53f; }
+f32 bark_to_freq(f32 bark) { return 1960.0f * (bark + 0.53f) / (26.28f - bark); }
+
+enum FilterScale
 {
-	Bands b;
-	// Define mel boundaries
-	Mel ranges[] = {
-		{ freq_to_mel(20.0f),   freq_to_mel(60.0f)    }, // sub bass
-		{ freq_to_mel(60.0f),   freq_to_mel(250.0f)   }, // bass
-		{ freq_to_mel(250.0f),  freq_to_mel(500.0f)   }, // low mid
-		{ freq_to_mel(500.0f),  freq_to_mel(2000.0f)  }, // mid
-		{ freq_to_mel(2000.0f), freq_to_mel(4000.0f)  }, // high mid
-		{ freq_to_mel(4000.0f), freq_to_mel(10000.0f) }  // high
-	};
+	SCALE_LINEAR,
+	SCALE_MEL,
+	SCALE_BARK,
+	SCALE_LOG
+};
 
-	f32* bands[] = { &b.sub_bass, &b.bass, &b.low_mid, &b.mid, &b.high_mid, &b.high };
+enum FilterShape
+{
+	FILTER_RECTANGULAR, // Mean over [edge b, edge b + 1]
+	FILTER_TRIANGULAR   // Rises over [edge b, edge b + 1], falls over [edge b + 1, edge b + 2]
+};
+
+/*
+	Filterbank
+		Maps a spectrum of bins to bands through precomputed weights. Each
+		band only stores the contiguous range of bins it covers, so apply is
+		one pass over roughly the spectrum size regardless of band count.
+		Weights of a band sum to 1: rectangular bands average, triangular
+		bands are area normalized. A band narrower than a bin takes the bin
+		nearest to its center.
+*/
+class Filterbank
+{
+public:
+	Filterbank() {}
 
-	for (s32 band = 0; band < 6; band++)
+	// bands spaced evenly on scale between min_freq and max_freq
+	Filterbank(s32 bands, f32 min_freq, f32 max_freq, FilterScale scale, FilterShape shape,
+		s32 bins = BINS, f32 freq_per_bin = FREQ_PER_BIN)
 	{
-		f32 sum = 0.0f;
+		s32 edges = bands + (shape == FILTER_TRIANGULAR ? 2 : 1);
+		f32 lo = to_scale(scale, min_freq);
+		f32 hi = to_scale(scale, max_freq);
+
+		std::vector<f32> hz(edges);
+		for (s32 i = 0; i < edges; i++)
+			hz[i] = from_scale(scale, lo + (hi - lo) * i / (edges - 1));
+
+		Build(hz, shape, bins, freq_per_bin);
+	}
+
+	// Explicit band edges in Hz
+	Filterbank(const std::vector<f32>& edges, FilterShape shape, s32 bins = BINS, f32 freq_per_bin = FREQ_PER_BIN)
+	{
+		Build(edges, shape, bins, freq_per_bin);
+	}
+
+public:
+	s32 Bands() const { return static_cast<s32>(m_ranges.size()); }
+
+	// out[b] = sum w * in
+	void apply(const f32* in, f32* out) const
+	{
+		for (size_t b = 0; b < m_ranges.size(); b++)
+			out[b] = Dot(m_ranges[b], in, false);
+	}
+
+	// out[b] = sqrt(sum w * in^2), RMS of magnitudes
+	void apply_rms(const f32* magnitude, f32* out) const
+	{
+		for (size_t b = 0; b < m_ranges.size(); b++)
+			out[b] = std::sqrt(Dot(m_ranges[b], magnitude, true));
+	}
+
+	static f32 to_scale(FilterScale scale, f32 freq)
+	{
+		switch (scale)
+		{
+		case SCALE_MEL:  return freq_to_mel(freq);
+		case SCALE_BARK: return freq_to_bark(freq);
+		case SCALE_LOG:  return std::log2(std::max(freq, 1.0f));
+		default:         return freq;
+		}
+	}
+
+	static f32 from_scale(FilterScale scale, f32 value)
+	{
+		switch (scale)
+		{
+		case SCALE_MEL:  return mel_to_freq(value);
+		case SCALE_BARK: return bark_to_freq(value);
+		case SCALE_LOG:  return std::exp2(value);
+		default:         return value;
+		}
+	}
+
+private:
+	struct Range
+	{
+		s32 first = 0;  // First bin
 		s32 count = 0;
-		for (s32 i = 1; i < BINS; i++)
+		s32 offset = 0; // Into m_weights
+	};
+
+	void Build(const std::vector<f32>& edges, FilterShape shape, s32 bins, f32 freq_per_bin)
+	{
+		s32 span = shape == FILTER_TRIANGULAR ? 2 : 1;
+		s32 bands = static_cast<s32>(edges.size()) - span;
+
+		for (s32 b = 0; b < bands; b++)
 		{
-			f32 freq = i * FREQ_PER_BIN;
-			f32 mel = freq_to_mel(freq);
+			f32 lo = edges[b];
+			f32 hi = edges[b + span];
+			f32 mid = shape == FILTER_TRIANGULAR ? edges[b + 1] : 0.5f * (lo + hi);
+
+			Range r;
+			r.offset = static_cast<s32>(m_weights.size());
+			r.first = -1;
+
+			f32 sum = 0.0f;
+			for (s32 i = 1; i < bins; i++)
+			{
+				f32 freq = i * freq_per_bin;
+				if (freq < lo || freq > hi)
+					continue;
+
+				f32 w = 1.0f;
+				if (shape == FILTER_TRIANGULAR)
+					w = freq <= mid ? (freq - lo) / std::max(mid - lo, 1e-6f) : (hi - freq) / std::max(hi - mid, 1e-6f);
+
+				if (r.first < 0)
+					r.first = i;
+				m_weights.push_back(w);
+				sum += w;
+				r.count++;
+			}
 
-			if (mel >= ranges[band].min && mel <= ranges[band].max)
+			if (sum <= 0.0f)
 			{
-				f32 magnitude = fft[i];
-				sum += magnitude * magnitude;
-				count++;
+				// Narrower than a bin
+				m_weights.resize(r.offset);
+				r.first = std::clamp(static_cast<s32>(std::round(mid / freq_per_bin)), 0, bins - 1);
+				r.count = 1;
+				m_weights.push_back(1.0f);
+				sum = 1.0f;
 			}
+
+			for (s32 i = 0; i < r.count; i++)
+				m_weights[r.offset + i] /= sum;
+
+			m_ranges.push_back(r);
 		}
+	}
 
-		*bands[band] = count > 0 ? sqrt(sum / count) : 0.0f;
+	// Four partial sums so the loop vectorizes without reassociation flags
+	f32 Dot(const Range& r, const f32* in, bool square) const
+	{
+		const f32* w = m_weights.data() + r.offset;
+		const f32* x = in + r.first;
+		f32 acc[4] = {};
+		s32 i = 0;
+		for (; i + 4 <= r.count; i += 4)
+			for (s32 j = 0; j < 4; j++)
+				acc[j] += w[i + j] * (square ? x[i + j] * x[i + j] : x[i + j]);
+		for (; i < r.count; i++)
+			acc[0] += w[i] * (square ? x[i] * x[i] : x[i]);
+		return (acc[0] + acc[1]) + (acc[2] + acc[3]);
 	}
 
+private:
+	std::vector<Range> m_ranges;
+	std::vector<f32> m_weights;
+};
+
+// Band edges of extract_bands in Hz, bins are spaced by the analysis sample rate
+Filterbank band_filterbank(f32 freq_per_bin = FREQ_PER_BIN)
+{
+	return Filterbank({ 20.0f, 60.0f, 250.0f, 500.0f, 2000.0f, 4000.0f, 10000.0f }, FILTER_RECTANGULAR, BINS, freq_per_bin);
+}
+
+Bands extract_bands(const f32* fft, const Filterbank& bank)
+{
+	// RMS over the band ranges
+	f32 rms[6];
+	bank.apply_rms(fft, rms);
+
+	Bands b;
+	b.sub_bass = rms[0];
+	b.bass     = rms[1];
+	b.low_mid  = rms[2];
+	b.mid      = rms[3];
+	b.high_mid = rms[4];
+	b.high     = rms[5];
+
 	// Compensate for low frequency energy
 	b.sub_bass *= 3.0f;
 	b.bass     *= 2.5f;
@@ -84,6 +487,12 @@ Bands extract_bands(const f32* fft)
 	return b;
 }
 
+Bands extract_bands(const f32* fft)
+{
+	static const Filterbank bank = band_filterbank();
+	return extract_bands(fft, bank);
+}
+
 // Improved smoothing with adaptive attack/release
 f32 smoothing(f32 prev, f32 curr, f32 attack, f32 release)
 {
@@ -91,85 +500,491 @@ f32 smoothing(f32 prev, f32 curr, f32 attack, f32 release)
 	return prev + alpha * (curr - prev);
 }
 
-struct BandProcessor
+/*
+	Envelope Processor
+		Per band envelope following over contiguous arrays, any band count.
+			smooth   fast attack, slower release follower of the input
+			average  very slow follower, the adaptive threshold
+			peak     instant attack, slow decay
+			motion   smoothed excess of smooth over headroom * average,
+			         normalized by the peak
+		Onsets flag the rising edge of the normalized excess through
+		onset_threshold. Every step is written as selects and min / max, so
+		the loop has no data dependent branches; four bands are processed
+		per SSE instruction where available.
+*/
+#if defined(_M_X64) || defined(__SSE2__)
+	#include <emmintrin.h>
+	#define GLT_DSP_SSE2 1
+#endif
+
+struct EnvelopeSettings
 {
-	Bands smooth;
-	Bands average;
-	Bands motion;
-	Bands peak;
+	f32 attack          = 0.25f;
+	f32 release         = 0.08f;
+	f32 average_rate    = 0.003f;
+	f32 peak_decay      = 0.001f;
+	f32 headroom        = 1.2f;  // Threshold over the average
+	f32 motion_attack   = 0.15f;
+	f32 motion_release  = 0.10f;
+	f32 onset_threshold = 0.5f;
+};
 
-	// Adaptive thresholds
-	f32 noise_floor = 0.0f;
-	Bands update(const Bands& raw)
+class EnvelopeProcessor
+{
+public:
+	EnvelopeProcessor(s32 bands = 6, EnvelopeSettings settings = {}) : m_settings(settings)
 	{
-		// Envelope following with different attack/release
-		auto env = [](f32 p, f32 c) {
-			return smoothing(p, c, 0.25f, 0.08f); // Fast attack, slower release
-		};
+		Resize(bands);
+	}
 
-		smooth.sub_bass = env(smooth.sub_bass, raw.sub_bass);
-		smooth.bass     = env(smooth.bass,     raw.bass);
-		smooth.low_mid  = env(smooth.low_mid,  raw.low_mid);
-		smooth.mid      = env(smooth.mid,      raw.mid);
-		smooth.high_mid = env(smooth.high_mid, raw.high_mid);
-		smooth.high     = env(smooth.high,     raw.high);
+public:
+	void Resize(s32 bands)
+	{
+		m_bands = bands;
+		size_t padded = (bands + 3) & ~3;
+		for (std::vector<f32>* v : { &m_smooth, &m_average, &m_peak, &m_delta, &m_motion })
+			v->assign(padded, 0.0f);
+		m_onset.assign(padded, 0);
+	}
 
-		// Long-term average (for adaptive threshold)
-		auto avg = [](f32 p, f32 c) {
-			return smoothing(p, c, 0.003f, 0.003f); // Very slow
-		};
+	// raw: Bands() values, motion and onsets are read from the accessors
+	void update(const f32* raw)
+	{
+		const EnvelopeSettings& e = m_settings;
+		s32 i = 0;
 
-		average.sub_bass = avg(average.sub_bass, smooth.sub_bass);
-		average.bass     = avg(average.bass,     smooth.bass);
-		average.low_mid  = avg(average.low_mid,  smooth.low_mid);
-		average.mid      = avg(average.mid,      smooth.mid);
-		average.high_mid = avg(average.high_mid, smooth.high_mid);
-		average.high     = avg(average.high,     smooth.high);
-
-		// Peak tracking
-		auto track_peak = [](f32 p, f32 c) {
-			if (c > p) return c;
-			return smoothing(p, c, 0.0f, 0.001f); // Only decay
+#ifdef GLT_DSP_SSE2
+		auto follow4 = [](__m128 p, __m128 c, __m128 up, __m128 down) {
+			__m128 rising = _mm_cmpgt_ps(c, p);
+			__m128 alpha = _mm_or_ps(_mm_and_ps(rising, up), _mm_andnot_ps(rising, down));
+			return _mm_add_ps(p, _mm_mul_ps(alpha, _mm_sub_ps(c, p)));
 		};
 
-		peak.sub_bass = track_peak(peak.sub_bass, smooth.sub_bass);
-		peak.bass     = track_peak(peak.bass,     smooth.bass);
-		peak.low_mid  = track_peak(peak.low_mid,  smooth.low_mid);
-		peak.mid      = track_peak(peak.mid,      smooth.mid);
-		peak.high_mid = track_peak(peak.high_mid, smooth.high_mid);
-		peak.high     = track_peak(peak.high,     smooth.high);
-
-		// Delta
-		Bands delta;
-		auto calc_delta = [](f32 s, f32 a, f32 p) {
-			f32 threshold = a * 1.2f; // 20% above average
-			f32 normalized = (s - threshold) / (p - threshold + 0.001f);
-			return std::max(normalized, 0.0f);
-		};
+		__m128 attack   = _mm_set1_ps(e.attack),        release  = _mm_set1_ps(e.release);
+		__m128 avg_rate = _mm_set1_ps(e.average_rate),  decay    = _mm_set1_ps(e.peak_decay);
+		__m128 headroom = _mm_set1_ps(e.headroom),      epsilon  = _mm_set1_ps(0.001f);
+		__m128 m_attack = _mm_set1_ps(e.motion_attack), m_release = _mm_set1_ps(e.motion_release);
+		__m128 onset    = _mm_set1_ps(e.onset_threshold);
+		__m128 zero     = _mm_setzero_ps();
 
-		delta.sub_bass = calc_delta(smooth.sub_bass, average.sub_bass, peak.sub_bass);
-		delta.bass     = calc_delta(smooth.bass,     average.bass,     peak.bass);
-		delta.low_mid  = calc_delta(smooth.low_mid,  average.low_mid,  peak.low_mid);
-		delta.mid      = calc_delta(smooth.mid,      average.mid,      peak.mid);
-		delta.high_mid = calc_delta(smooth.high_mid, average.high_mid, peak.high_mid);
-		delta.high     = calc_delta(smooth.high,     average.high,     peak.high);
+		for (; i + 4 <= m_bands; i += 4)
+		{
+			__m128 c = _mm_loadu_ps(raw + i);
 
-		// Motion smoothing
-		auto mot = [](f32 p, f32 c) {
-			return smoothing(p, c, 0.15f, 0.10f);
-		};
+			__m128 smooth  = follow4(_mm_load_ps(&m_smooth[i]), c, attack, release);
+			__m128 average = follow4(_mm_load_ps(&m_average[i]), smooth, avg_rate, avg_rate);
+
+			__m128 p = _mm_load_ps(&m_peak[i]);
+			__m128 peak = _mm_max_ps(smooth, _mm_add_ps(p, _mm_mul_ps(decay, _mm_sub_ps(smooth, p))));
+
+			__m128 threshold = _mm_mul_ps(average, headroom);
+			__m128 excess = _mm_div_ps(_mm_sub_ps(smooth, threshold), _mm_add_ps(_mm_sub_ps(peak, threshold), epsilon));
+			__m128 delta = _mm_max_ps(excess, zero);
+
+			__m128 motion = follow4(_mm_load_ps(&m_motion[i]), delta, m_attack, m_release);
+
+			// Rising edge through the onset threshold
+			__m128 above = _mm_cmpgt_ps(delta, onset);
+			__m128 was_above = _mm_cmpgt_ps(_mm_load_ps(&m_delta[i]), onset);
+			s32 mask = _mm_movemask_ps(_mm_andnot_ps(was_above, above));
+
+			_mm_store_ps(&m_smooth[i], smooth);
+			_mm_store_ps(&m_average[i], average);
+			_mm_store_ps(&m_peak[i], peak);
+			_mm_store_ps(&m_delta[i], delta);
+			_mm_store_ps(&m_motion[i], motion);
+			for (s32 j = 0; j < 4; j++)
+				m_onset[i + j] = (mask >> j) & 1;
+		}
+#endif
+
+		for (; i < m_bands; i++)
+		{
+			f32 smooth  = smoothing(m_smooth[i], raw[i], e.attack, e.release);
+			f32 average = smoothing(m_average[i], smooth, e.average_rate, e.average_rate);
+			f32 peak    = std::max(smooth, m_peak[i] + e.peak_decay * (smooth - m_peak[i]));
+
+			f32 threshold = average * e.headroom;
+			f32 delta = std::max((smooth - threshold) / (peak - threshold + 0.001f), 0.0f);
+
+			m_onset[i]   = delta > e.onset_threshold && !(m_delta[i] > e.onset_threshold);
+			m_smooth[i]  = smooth;
+			m_average[i] = average;
+			m_peak[i]    = peak;
+			m_delta[i]   = delta;
+			m_motion[i]  = smoothing(m_motion[i], delta, e.motion_attack, e.motion_release);
+		}
+	}
+
+	void Reset() { Resize(m_bands); }
+
+	s32 Bands() const { return m_bands; }
+	EnvelopeSettings& Settings() { return m_settings; }
 
-		motion.sub_bass = mot(motion.sub_bass, delta.sub_bass);
-		motion.bass     = mot(motion.bass,     delta.bass);
-		motion.low_mid  = mot(motion.low_mid,  delta.low_mid);
-		motion.mid      = mot(motion.mid,      delta.mid);
-		motion.high_mid = mot(motion.high_mid, delta.high_mid);
-		motion.high     = mot(motion.high,     delta.high);
+	const f32* Smooth()  const { return m_smooth.data(); }
+	const f32* Average() const { return m_average.data(); }
+	const f32* Peak()    const { return m_peak.data(); }
+	const f32* Motion()  const { return m_motion.data(); }
+	const u8*  Onsets()  const { return m_onset.data(); }
 
+private:
+	s32 m_bands = 0;
+	EnvelopeSettings m_settings;
+
+	// Padded to a multiple of 4
+	std::vector<f32> m_smooth;
+	std::vector<f32> m_average;
+	std::vector<f32> m_peak;
+	std::vector<f32> m_delta;
+	std::vector<f32> m_motion;
+	std::vector<u8>  m_onset;
+};
+
+// Six named bands on top of EnvelopeProcessor
+struct BandProcessor
+{
+	EnvelopeProcessor envelope = EnvelopeProcessor(6);
+
+	Bands update(const Bands& raw)
+	{
+		f32 in[6] = { raw.sub_bass, raw.bass, raw.low_mid, raw.mid, raw.high_mid, raw.high };
+		envelope.update(in);
+
+		const f32* m = envelope.Motion();
+		Bands motion;
+		motion.sub_bass = m[0];
+		motion.bass     = m[1];
+		motion.low_mid  = m[2];
+		motion.mid      = m[3];
+		motion.high_mid = m[4];
+		motion.high     = m[5];
 		return motion;
 	}
 };
 
+/*
+	Onset Detection
+		SpectralFlux is the novelty function: the summed positive change of
+		the log compressed spectrum from one frame to the next. Log
+		compression keeps quiet transients from being masked by loud
+		sustained partials. Feeding it mel bands instead of FFT bins costs a
+		fraction and is less sensitive to vibrato.
+
+		OnsetDetector picks peaks of the novelty against an adaptive
+		threshold, the median of the surrounding window scaled and offset,
+		so the detector follows the dynamics of the track. A frame is an
+		onset when it is a local maximum above the threshold and at least
+		min_interval after the previous one. Peaks are confirmed one frame
+		late, once the next value is known.
+*/
+class SpectralFlux
+{
+public:
+	SpectralFlux(s32 bins = BINS, f32 compression = 1.0f) : m_compression(compression)
+	{
+		m_previous.assign(bins, 0.0f);
+		m_current.assign(bins, 0.0f);
+	}
+
+public:
+	// spectrum: Bins() magnitudes, the first call measures against silence
+	f32 update(const f32* spectrum)
+	{
+		s32 bins = Bins();
+		for (s32 i = 0; i < bins; i++)
+			m_current[i] = std::log1p(m_compression * spectrum[i]);
+
+		f32 sum[4] = {};
+		s32 i = 0;
+		for (; i + 4 <= bins; i += 4)
+			for (s32 j = 0; j < 4; j++)
+				sum[j] += std::max(m_current[i + j] - m_previous[i + j], 0.0f);
+		for (; i < bins; i++)
+			sum[0] += std::max(m_current[i] - m_previous[i], 0.0f);
+
+		m_previous.swap(m_current);
+		return (sum[0] + sum[1] + sum[2] + sum[3]) / bins;
+	}
+
+	void Reset() { std::fill(m_previous.begin(), m_previous.end(), 0.0f); }
+
+	s32 Bins() const { return static_cast<s32>(m_previous.size()); }
+
+private:
+	f32 m_compression;
+	std::vector<f32> m_previous;
+	std::vector<f32> m_current;
+};
+
+struct OnsetSettings
+{
+	f32 median_window = 0.5f;  // Seconds of novelty the threshold looks at
+	f32 multiplier    = 1.5f;  // Threshold over the median
+	f32 offset        = 0.01f; // Keeps silence from triggering
+	f32 min_interval  = 0.08f; // Seconds between onsets
+};
+
+class OnsetDetector
+{
+public:
+	OnsetDetector(f32 frame_rate = SAMPLE_RATE / 512.0f, OnsetSettings settings = {}) : m_settings(settings)
+	{
+		s32 window = std::max(3, static_cast<s32>(settings.median_window * frame_rate) | 1);
+		m_history.assign(window, 0.0f);
+		m_sorted.resize(window);
+		m_min_gap = std::max(1, static_cast<s32>(settings.min_interval * frame_rate + 0.5f));
+		m_since = m_min_gap;
+	}
+
+public:
+	// novelty: SpectralFlux output, returns true when the previous frame was an onset
+	bool update(f32 novelty)
+	{
+		s32 window = static_cast<s32>(m_history.size());
+		m_history[m_head] = novelty;
+		m_head = (m_head + 1) % window;
+
+		// Median of the window, bounded by its size
+		std::copy(m_history.begin(), m_history.end(), m_sorted.begin());
+		std::nth_element(m_sorted.begin(), m_sorted.begin() + window / 2, m_sorted.end());
+		f32 threshold = m_sorted[window / 2] * m_settings.multiplier + m_settings.offset;
+
+		bool peak = m_current > m_previous && m_current >= novelty && m_current > m_threshold;
+		m_onset = peak && m_since >= m_min_gap;
+		m_since = m_onset ? 1 : m_since + 1;
+
+		// Strength of the confirmed frame over its threshold
+		m_strength = std::max(m_current - m_threshold, 0.0f);
+
+		m_previous = m_current;
+		m_current = novelty;
+		m_threshold = threshold;
+		return m_onset;
+	}
+
+	void Reset()
+	{
+		std::fill(m_history.begin(), m_history.end(), 0.0f);
+		m_head = 0;
+		m_previous = m_current = m_threshold = m_strength = 0.0f;
+		m_since = m_min_gap;
+		m_onset = false;
+	}
+
+	bool Onset() const { return m_onset; }
+	f32 Strength() const { return m_strength; }
+	f32 Threshold() const { return m_threshold; }
+
+private:
+	OnsetSettings m_settings;
+	std::vector<f32> m_history;
+	std::vector<f32> m_sorted;
+	s32 m_head = 0;
+
+	f32 m_previous = 0.0f;
+	f32 m_current = 0.0f;
+	f32 m_threshold = 0.0f;
+	f32 m_strength = 0.0f;
+	s32 m_min_gap = 1;
+	s32 m_since = 1;
+	bool m_onset = false;
+};
+
+/*
+	Tempo Tracking
+		The novelty is detrended against its running mean and kept in a
+		short history. Every frame each lag's autocorrelation is updated as
+		an exponential average, so old material fades out over memory
+		seconds and a tempo change is followed. Each candidate period
+		scores its own lag plus half of its double, which favors the true
+		period over its half, weighted by a log normal prior around
+		prior_bpm. The best lag is refined by parabolic interpolation.
+
+		Phase comes from a comb: for every offset in one period the
+		novelty at offset, offset + period, ... is summed; the best offset
+		is the time since the last beat. A phase oscillator runs at the
+		estimated period and is pulled towards that target, more strongly
+		the more confident the estimate.
+
+		Confidence is the height of the best autocorrelation peak above
+		the mean over the lag range, relative to the zero lag energy.
+		Per frame cost is O(2 * max_lag + combs * period), a few hundred
+		multiply adds at hop rate.
+*/
+struct TempoSettings
+{
+	f32 min_bpm    = 60.0f;
+	f32 max_bpm    = 200.0f;
+	f32 prior_bpm  = 120.0f;
+	f32 prior_width = 1.0f;   // Octaves, standard deviation of the prior
+	f32 memory     = 6.0f;    // Seconds the autocorrelation averages over
+	s32 combs      = 4;       // Periods summed for the phase estimate
+	f32 phase_gain = 0.15f;   // Pull towards the comb phase per frame
+};
+
+class TempoTracker
+{
+public:
+	TempoTracker(f32 frame_rate = SAMPLE_RATE / 512.0f, TempoSettings settings = {})
+		: m_frame_rate(frame_rate), m_settings(settings)
+	{
+		m_min_lag = std::max(1, static_cast<s32>(60.0f * frame_rate / settings.max_bpm));
+		m_max_lag = std::max(m_min_lag + 2, static_cast<s32>(std::ceil(60.0f * frame_rate / settings.min_bpm)));
+
+		// History covers the doubled lag and every comb tooth
+		s32 needed = std::max(2 * m_max_lag, (settings.combs + 1) * m_max_lag) + 1;
+		s32 size = 1;
+		while (size < needed) size <<= 1;
+		m_history.assign(size, 0.0f);
+		m_mask = size - 1;
+
+		m_acf.assign(2 * m_max_lag + 1, 0.0f);
+		m_prior.assign(m_max_lag + 1, 0.0f);
+		for (s32 lag = m_min_lag; lag <= m_max_lag; lag++)
+		{
+			f32 octaves = std::log2(60.0f * frame_rate / lag / settings.prior_bpm) / settings.prior_width;
+			m_prior[lag] = std::exp(-0.5f * octaves * octaves);
+		}
+
+		m_decay = std::exp(-1.0f / (settings.memory * frame_rate));
+		m_period = 60.0f * frame_rate / settings.prior_bpm;
+	}
+
+public:
+	// novelty: one value per frame, SpectralFlux output or onset strength
+	void update(f32 novelty)
+	{
+		const TempoSettings& t = m_settings;
+
+		// Detrend, only rises above the running mean count
+		m_mean = smoothing(m_mean, novelty, 0.02f, 0.02f);
+		f32 x = std::max(novelty - m_mean, 0.0f);
+
+		m_head = (m_head + 1) & m_mask;
+		m_history[m_head] = x;
+
+		// Exponentially weighted autocorrelation, lag 0 is the energy
+		f32 gain = 1.0f - m_decay;
+		s32 lags = static_cast<s32>(m_acf.size());
+		for (s32 lag = 0; lag < lags; lag++)
+			m_acf[lag] = m_decay * m_acf[lag] + gain * x * History(lag);
+
+		// Best period, own lag plus half the double
+		s32 best = m_min_lag;
+		f32 best_score = -1.0f;
+		f32 sum = 0.0f;
+		for (s32 lag = m_min_lag; lag <= m_max_lag; lag++)
+		{
+			f32 score = Score(lag);
+			sum += m_acf[lag];
+			if (score > best_score)
+			{
+				best_score = score;
+				best = lag;
+			}
+		}
+
+		f32 period = static_cast<f32>(best);
+		if (best > m_min_lag && best < m_max_lag)
+		{
+			f32 a = Score(best - 1), b = best_score, c = Score(best + 1);
+			f32 d = a - 2.0f * b + c;
+			if (d < 0.0f)
+				period += 0.5f * (a - c) / d;
+		}
+
+		f32 mean = sum / (m_max_lag - m_min_lag + 1);
+		f32 confidence = m_acf[0] > 1e-9f ? std::clamp((m_acf[best] - mean) / (m_acf[0] - mean + 1e-9f), 0.0f, 1.0f) : 0.0f;
+		m_confidence = smoothing(m_confidence, confidence, 0.05f, 0.05f);
+		m_period = period;
+
+		// Comb over one period, the best offset is the time since the last beat
+		s32 p = std::max(1, static_cast<s32>(period + 0.5f));
+		s32 best_offset = 0;
+		f32 best_comb = -1.0f;
+		for (s32 offset = 0; offset < p; offset++)
+		{
+			f32 comb = 0.0f;
+			for (s32 k = 0; k < t.combs; k++)
+				comb += History(offset + static_cast<s32>(k * period + 0.5f));
+			if (comb > best_comb)
+			{
+				best_comb = comb;
+				best_offset = offset;
+			}
+		}
+
+		// Advance the oscillator, then pull it towards the comb phase
+		m_beat = false;
+		m_phase += 1.0f / period;
+		if (m_phase >= 1.0f)
+		{
+			m_phase -= std::floor(m_phase);
+			m_beat = m_since_beat >= period * 0.5f;
+			if (m_beat)
+				m_since_beat = 0;
+		}
+		m_since_beat++;
+
+		if (best_comb > 0.0f)
+		{
+			f32 error = static_cast<f32>(best_offset) / period - m_phase;
+			error -= std::floor(error + 0.5f);
+			m_phase += t.phase_gain * m_confidence * error;
+			m_phase -= std::floor(m_phase);
+		}
+	}
+
+	void Reset()
+	{
+		std::fill(m_history.begin(), m_history.end(), 0.0f);
+		std::fill(m_acf.begin(), m_acf.end(), 0.0f);
+		m_head = 0;
+		m_mean = 0.0f;
+		m_period = 60.0f * m_frame_rate / m_settings.prior_bpm;
+		m_phase = 0.0f;
+		m_confidence = 0.0f;
+		m_since_beat = 0;
+		m_beat = false;
+	}
+
+	f32 Bpm() const { return 60.0f * m_frame_rate / m_period; }
+	f32 Period() const { return m_period; }         // Frames per beat
+	f32 Phase() const { return m_phase; }           // [0, 1), 0 on the beat
+	f32 Confidence() const { return m_confidence; } // [0, 1]
+	bool Beat() const { return m_beat; }            // Phase wrapped this frame
+
+	TempoSettings& Settings() { return m_settings; }
+
+private:
+	// Novelty lag frames ago
+	f32 History(s32 lag) const { return m_history[(m_head - lag) & m_mask]; }
+
+	f32 Score(s32 lag) const { return m_prior[lag] * (m_acf[lag] + 0.5f * m_acf[2 * lag]); }
+
+private:
+	f32 m_frame_rate;
+	TempoSettings m_settings;
+
+	s32 m_min_lag = 1;
+	s32 m_max_lag = 2;
+	std::vector<f32> m_history;
+	s32 m_mask = 0;
+	s32 m_head = 0;
+
+	std::vector<f32> m_acf;
+	std::vector<f32> m_prior;
+	f32 m_decay = 0.0f;
+	f32 m_mean = 0.0f;
+
+	f32 m_period = 1.0f;
+	f32 m_phase = 0.0f;
+	f32 m_confidence = 0.0f;
+	s32 m_since_beat = 0;
+	bool m_beat = false;
+};
+
 // Soft knee Compression
 f32 compress(f32 x, f32 threshold = 0.5f, f32 ratio = 4.0f)
 {
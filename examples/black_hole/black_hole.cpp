@@ -60,7 +60,7 @@ class BlackHole : public Application
 public:
 	BlackHole() {}
 
-	std::unique_ptr<Shader> black_hole_shader;
+	std::shared_ptr<Shader> black_hole_shader;
 
 	std::unique_ptr<Sphere> sphere;
 	std::unique_ptr<Ring> ring;
@@ -89,7 +89,7 @@ public:
 		// Black Hole
 		sphere = std::make_unique<Sphere>();
 		ring   = std::make_unique<Ring>(2.0f, 3.0f);
-		black_hole_shader = std::make_unique<Shader>("res/shaders/basic/default.vs", "res/shaders/black_hole/black_hole.fs");
+		black_hole_shader = m_shaders.Load("black_hole", "res/shaders/basic/default.vs", "res/shaders/black_hole/black_hole.fs");
 
 		// Camera
 		vf3 eye    = { 0.0f, 0.0f, 3.0f };
@@ -160,9 +160,8 @@ public:
 		black_hole_shader->SetUniform("proj_view", model_view_projection);
 		//shader->SetUniform("proj_view", camera.proj_camera());
 
-		sphere->draw(GL_TRIANGLES);
-		ring->draw(GL_TRIANGLES);
-		black_hole_shader->Unuse();
+		sphere->submit(m_queue, *black_hole_shader, GL_TRIANGLES);
+		ring->submit(m_queue, *black_hole_shader, GL_TRIANGLES);
 
 	}
 };
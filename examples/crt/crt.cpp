@@ -3,18 +3,23 @@
 #include "Graphics/Sprite.h"
 #include "Graphics/Shader.h"
 #include "Graphics/PostProcessor.h"
+#include "Graphics/UniformBuffer.h"
 
 class CRT : public Application
 {
 public:
 	CRT() {}
 	std::unique_ptr<Sprite> sprite;
-	std::unique_ptr<Shader> crt_shader;
+	std::shared_ptr<Shader> crt_shader;
+	std::shared_ptr<Shader> blur_shader;
 	std::unique_ptr<Shader> texture_shader;
 	std::unique_ptr<PostProcessor> post_processor;
 
-	struct SimpleCRTConfig
+	// std140 mirror of the SimpleCRTConfig block in simple_crt.fs
+	struct alignas(16) SimpleCRTConfig
 	{
+		vf2 screen_resolution = { 0.0f, 0.0f };
+
 		float scanline_amplitude = 0.3f;
 		float scanline_frequency = 1920.0f;
 		float scanline_offset = 1.20f;
@@ -39,13 +44,46 @@ public:
 		float bloom_blend_factor = 0.5f;
 	} config;
 
+	std::unique_ptr<UniformBuffer<SimpleCRTConfig>> crt_config;
+	UniformHandle texture_screen;
+
 public:
 	void Create() override
 	{
 		sprite = std::make_unique<Sprite>("res/images/wizardRL.png");
 		texture_shader = std::make_unique<Shader>("res/shaders/basic/texture.vs", "res/shaders/basic/texture.fs");
-		crt_shader = std::make_unique<Shader>("res/shaders/post_processing/post_processing.vs", "res/shaders/post_processing/simple_crt.fs");
 		post_processor = std::make_unique<PostProcessor>(m_window.Width(), m_window.Height());
+
+		// Register the block before the shader links so it binds automatically
+		crt_config = std::make_unique<UniformBuffer<SimpleCRTConfig>>("SimpleCRTConfig", USER_BINDING);
+		crt_shader = m_shaders.Load("crt", "res/shaders/post_processing/post_processing.vs", "res/shaders/post_processing/simple_crt.fs");
+		blur_shader = m_shaders.Load("blur", "res/shaders/post_processing/post_processing.vs", "res/shaders/post_processing/blur.fs");
+		texture_screen = texture_shader->GetHandle("screen_texture");
+		config.screen_resolution = { m_window.Width(), m_window.Height() };
+
+		// Separable blur shared by color bleeding and bloom, then the CRT pass
+		PostPass blur_h;
+		blur_h.name     = "blur_h";
+		blur_h.shader   = blur_shader;
+		blur_h.inputs   = { { "scene", "screen_texture" } };
+		blur_h.uniforms = [&](Shader& s) { s.SetUniform("direction", vf2(config.blur_radius, 0.0f)); };
+		post_processor->AddPass(blur_h);
+
+		PostPass blur_v;
+		blur_v.name     = "blur";
+		blur_v.shader   = blur_shader;
+		blur_v.inputs   = { { "blur_h", "screen_texture" } };
+		blur_v.uniforms = [&](Shader& s) { s.SetUniform("direction", vf2(0.0f, config.blur_radius)); };
+		post_processor->AddPass(blur_v);
+
+		// Bloom pyramid, composited by the CRT pass
+		post_processor->AddBloom("scene", false);
+
+		PostPass crt;
+		crt.name   = "crt";
+		crt.shader = crt_shader;
+		crt.inputs = { { "scene", "screen_texture" }, { "blur", "blur_texture" }, { "bloom", "bloom_texture" } };
+		post_processor->AddPass(crt);
 	}
 
 	void ProcessInput() override
@@ -65,36 +103,14 @@ public:
 		post_processor->Begin();
 
 		texture_shader->Use();
-		texture_shader->SetUniform("screen_texture", 0);
+		texture_shader->SetUniform(texture_screen, 0);
 
 		// Draw Texture
 		sprite->Draw();
 
-		// Post Processing
-		crt_shader->Use();
-		crt_shader->SetUniform("screen_texture", 0);
-
 		// Shader Uniforms
-		crt_shader->SetUniform("screen_resolution",     { m_window.Width(), m_window.Height() });
-		crt_shader->SetUniform("scanline_amplitude",    config.scanline_amplitude);
-		crt_shader->SetUniform("scanline_frequency",    config.scanline_frequency);
-		crt_shader->SetUniform("scanline_offset",       config.scanline_offset);
-		crt_shader->SetUniform("primary_curvature",     config.primary_curvature);
-		crt_shader->SetUniform("secondary_curvature",   config.secondary_curvature);
-		crt_shader->SetUniform("vignette_radius",       config.vignette_radius);
-		crt_shader->SetUniform("vignette_softness",     config.vignette_softness);
-		crt_shader->SetUniform("blur_radius",           config.blur_radius);
-		crt_shader->SetUniform("blend_factor",          config.blend_factor);
-		crt_shader->SetUniform("gamma",                 config.gamma);
-		crt_shader->SetUniform("contrast",              config.contrast);
-		crt_shader->SetUniform("saturation",            config.saturation);
-		crt_shader->SetUniform("brightness",            config.brightness);
-		crt_shader->SetUniform("color_correction",      config.color_correction);
-		crt_shader->SetUniform("phosphor_dot_scale",    config.phosphor_dot_scale);
-		crt_shader->SetUniform("phosphor_dot_softness", config.phosphor_dot_softness);
-		crt_shader->SetUniform("bloom_intensity",       config.bloom_intensity);
-		crt_shader->SetUniform("bloom_threshold",       config.bloom_threshold);
-		crt_shader->SetUniform("bloom_blend_factor",    config.bloom_blend_factor);
+		crt_config->Upload(config);
+		post_processor->Bloom().threshold = config.bloom_threshold;
 
 		post_processor->End();
 		post_processor->Render();
@@ -9,6 +9,7 @@
 #include "Graphics/Mesh.h"
 #include "Graphics/Texture.h"
 #include "Graphics/Shader.h"
+#include "Graphics/PostProcessor.h"
 
 #include "FastNoiseLite/FastNoiseLite.h"
 
@@ -21,6 +22,12 @@ public:
 	mf4x4 proj;
 	std::unique_ptr<Shader> shader = nullptr;
 	std::unique_ptr<Shader> circle_shader = nullptr;
+	std::unique_ptr<Shader> tonemap_shader = nullptr;
+
+	// Particles accumulate additively in an HDR scene, tonemapped on present
+	std::unique_ptr<PostProcessor> post_processor;
+	f32 trail_persistence = 0.995f;
+	f32 exposure = 1.0f;
 
 	// Particle
 	struct Particle
@@ -73,7 +80,8 @@ public:
 	f32 max_speed = 80.0f;
 
 	// RNG and Noise
-	Random rng;
+	CounterRandom rng;
+	u64 generation = 0;
 	FastNoiseLite noise;
 	f32 noise_frequency = 0.80f;
 	s32 noise_octaves = 6;
@@ -113,16 +121,17 @@ public:
 
 	void generate_particles()
 	{
+		// Particle i only depends on the seed, generation and i
+		CounterRandom spawn = rng.fork(generation++);
+		vf2 center = vf2(w, h) / 2.0f;
+		vf2 spread = vf2(w, h) / 16.0f;
+
 		particles.clear();
 		for (s32 i = 0; i < n_particles; i++)
 		{
 			Particle p;
-			//f32 x = rng.uniform(0.0f, w);
-			//f32 y = rng.uniform(0.0f, h);
-			f32 x = rng.normal(w /2, w / 16);
-			f32 y = rng.normal(h /2, h / 16);
-
-			p.pos = { x, y };
+			//p.pos = { spawn.uniform(i, 0.0f, w, 0), spawn.uniform(i, 0.0f, h, 1) };
+			p.pos = spawn.normal2(i, center, spread);
 			p.vel = { 0.0f, 0.0f };
 			p.color = { 0.875f, 0.01f, 0.01f, 0.025f };
 			p.acc = { 0.0f, 0.0f };
@@ -137,6 +146,7 @@ public:
 
 		shader        = std::make_unique<Shader>("res/shaders/basic/default.vs", "res/shaders/basic/default.fs");
 		circle_shader = std::make_unique<Shader>("res/shaders/flow_field/circle.vs", "res/shaders/flow_field/circle.fs");
+		tonemap_shader = std::make_unique<Shader>("res/shaders/post_processing/post_processing.vs", "res/shaders/post_processing/tonemap.fs");
 
 		noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
 		//noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
@@ -157,6 +167,10 @@ public:
 
 		proj = glm::ortho(0.0f, f32(w), 0.0f, f32(h), 0.1f, -1.0f);
 
+		// RGBA16F: no banding from faint additive particles, and fine enough that fading trails reach zero
+		post_processor = std::make_unique<PostProcessor>(w, h, SceneFormat{ GL_RGBA16F });
+		post_processor->SetClearColor({ 0.0f, 0.0f, 0.0f, 0.0f });
+
 		// Flow Field Grid
 		generate_flowfield();
 
@@ -167,7 +181,7 @@ public:
 		glGenVertexArrays(1, &VAO);
 		glGenBuffers(1, &VBO);
 
-		glBindVertexArray(VAO);
+		RenderState::BindVertexArray(VAO);
 		glBindBuffer(GL_ARRAY_BUFFER, VBO);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(Particle) * particles.size(), particles.data(), GL_DYNAMIC_DRAW);
 		
@@ -179,9 +193,9 @@ public:
 
 		glEnableVertexAttribArray(2);
 		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, color));
-		glBindVertexArray(0);
+		RenderState::BindVertexArray(0);
 
-		glEnable(GL_PROGRAM_POINT_SIZE);
+		RenderState::Enable(GL_PROGRAM_POINT_SIZE);
 	}
 
 	void ProcessInput() override
@@ -276,23 +290,25 @@ public:
 
 	void Render() override
 	{
-		if (clear_screen) 
-		{
-			glm::vec4 v = to_float({ 0,0,0,0 });
-			glClearColor(v.r, v.g, v.b, v.a);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		}
-		else
-		{
-			glClear(GL_DEPTH_BUFFER_BIT);
-		}
+		m_window.Clear();
+
+		// Without clearing, the previous frame fades into trails
+		post_processor->Begin(clear_screen ? 0.0f : trail_persistence);
+		u32 scene = post_processor->GetFramebuffer();
+		vi4 viewport = post_processor->GetViewport();
+		post_processor->End();
 
 		if (draw_flow_field)
 		{
 			shader->Use();
 			shader->SetUniform("projection", proj);
 			for (const auto& l : vector_lines)
-				l->draw(GL_LINES);
+			{
+				DrawPacket p = l->packet(*shader, GL_LINES);
+				p.framebuffer = scene;
+				p.viewport    = viewport;
+				m_queue.Submit(std::move(p));
+			}
 		}
 
 		if (draw_particles)
@@ -302,11 +318,25 @@ public:
 			circle_shader->SetUniform("size", particle_size);
 			circle_shader->SetUniform("max_speed", max_speed);
 
-			glBindVertexArray(VAO);
-			glDrawArrays(GL_POINTS, 0, (GLsizei)particles.size());
-			glBindVertexArray(0);
+			DrawPacket p;
+			p.framebuffer = scene;
+			p.viewport    = viewport;
+			p.program     = circle_shader->GetID();
+			p.vao         = VAO;
+			p.mode        = GL_POINTS;
+			p.indexed     = false;
+			p.count       = static_cast<u32>(particles.size());
+			p.blend_dst   = GL_ONE; // Additive
+			p.key         = RenderQueue::MakeKey(PASS_TRANSPARENT, p.program, 0, 0.0f);
+			m_queue.Submit(std::move(p));
 		}
 
+		// Present, sorted after the scene packets
+		tonemap_shader->Use();
+		tonemap_shader->SetUniform("screen_texture", 0);
+		tonemap_shader->SetUniform("exposure", exposure);
+		post_processor->Submit(m_queue, *tonemap_shader);
+
 		m_gui.m_func = [&]() {
 			ImGui::Begin("Flow Field Parameters");
 			ImGui::SliderFloat("Noise Scale",        &noise_scale,       0.01f, 2.0f); // larger the value, erratic the flow
@@ -318,6 +348,8 @@ public:
 			ImGui::SliderFloat("Particle Max Speed", &max_speed,         0.00f, 200.0f);
 			ImGui::Checkbox("Update Flow Field",     &update_flow_field);
 			ImGui::Checkbox("Clear Screen",          &clear_screen);
+			ImGui::SliderFloat("Trail Persistence",  &trail_persistence, 0.9f, 0.999f, "%.4f");
+			ImGui::SliderFloat("Exposure",           &exposure,          0.1f, 8.0f);
 			ImGui::Checkbox("Draw Flow Field",       &draw_flow_field);
 			ImGui::Checkbox("Draw Particles",        &draw_particles);
 			ImGui::End();
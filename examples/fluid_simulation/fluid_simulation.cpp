@@ -27,7 +27,8 @@ public:
 public:
 	std::unique_ptr<Sprite> sprite;
 	std::unique_ptr<Shader> texture_shader;
-	Random rng;
+	CounterRandom rng;
+	u64 tick = 0;
 
 	vf2 mouse_pos = {};
 	vf2 mouse_pos_prev = {};
@@ -45,7 +46,7 @@ public:
 		sprite = std::make_unique<Sprite>(m_window.Width(), m_window.Height());
 		texture_shader = std::make_unique<Shader>("res/shaders/basic/texture.vs", "res/shaders/basic/texture.fs");
 
-		fluid = new FluidModel(N, 0.2f, 0.0f, 0.0f);
+		fluid = new FluidModel(N, 0.0f, 0.0f);
 
 		noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
 		noise.SetSeed(1337);
@@ -74,19 +75,22 @@ public:
 		vf2 direction = { std::cosf(angle), std::sinf(angle) };
 		vf2 velocity = glm::normalize(direction) * speed;
 		position += direction;
-		position += rng.normal(0.0f, 0.05f);
+		position += rng.normal2(tick, vf2(0.0f), vf2(0.05f));
 
 		if (position.x < 0) position.x = m_window.Width() / scale;
 		if (position.y < 0) position.y = m_window.Height() / scale;
 		if (position.x > m_window.Width() / scale)  position.x = 0;
 		if (position.y > m_window.Height() / scale) position.y = 0;
 
-		fluid->AddDensity(fluid_cube, static_cast<s32>(position.x), static_cast<s32>(position.y), rng.uniformi(100, 150));
-		fluid->AddVelocity(fluid_cube, static_cast<s32>(position.x), static_cast<s32>(position.y), velocity.x, velocity.y);
+		fluid->AddDensity(static_cast<s32>(position.x), static_cast<s32>(position.y), rng.uniformi(tick, 100, 150, 2));
+		fluid->AddVelocity(static_cast<s32>(position.x), static_cast<s32>(position.y), velocity.x, velocity.y);
 	}
 
 	void Simulate(f32 dt) override
 	{
+		// One random block per step, lanes 0-1 jitter, 2-3 density
+		tick++;
+
 		if (update)
 		{
 			mouse_pos = m_input.GetMouse();
@@ -95,7 +99,7 @@ public:
 			vf2 velocity = (current - previous) * 0.01f;
 			
 			if (m_input.IsButtonPressed(GLFW_MOUSE_BUTTON_1))
-				fluid->AddDensity(static_cast<s32>(current.x), static_cast<s32>(current.y), rng.uniformi(25, 150));
+				fluid->AddDensity(static_cast<s32>(current.x), static_cast<s32>(current.y), rng.uniformi(tick, 25, 150, 3));
 			
 			fluid->AddVelocity(static_cast<s32>(current.x), static_cast<s32>(current.y), velocity.x, velocity.y);
 			mouse_pos_prev = mouse_pos;
@@ -107,10 +111,10 @@ public:
 			{
 				for (s32 j = -1; j <= 1; j++) 
 				{
-					fluid->AddDensity(fluid_cube, cx + i, cy + j, rng.uniformi(50, 150));
+					fluid->AddDensity(cx + i, cy + j, rng.uniformi(idx(cx + i, cy + j), 50, 150));
 				}
 			}
-			fluid->AddVelocity(fluid_cube, cx, cy, 0.0f, 0.0005f);
+			fluid->AddVelocity(cx, cy, 0.0f, 0.0005f);
 			*/
 
 			fluid->Simulate(dt*speed);
@@ -4,14 +4,16 @@
 #pragma once
 
 #include <vector>
+#include <cmath>
 #include "Core/Common.h"
+#include "Graphics/Color.h"
 
 // Grid Size
 static const s32 N = 256;
 // Grid Scale
 static const s32 scale = 4;
-// Index Function
-s32 idx(s32 x, s32 y) { return y * N + x; }
+// Index Function, n is the grid size
+inline s32 idx(s32 x, s32 y, s32 n = N) { return y * n + x; }
 // Forward declarations
 static void set_bnd(s32 b, std::vector<f32>& x, s32 N);
 static void lin_solve(s32 b, std::vector<f32>& x, std::vector<f32>& x0, f32 a, f32 c, s32 iter, s32 N);
@@ -33,7 +35,7 @@ struct FluidModel
 	std::vector<f32> vx0;
 	std::vector<f32> vy0;
 
-	FluidModel(s32 sz, s32 diffusion, s32 viscosity)
+	FluidModel(s32 sz, f32 diffusion, f32 viscosity)
 	{
 		size = sz;
 		diff = diffusion;
@@ -49,29 +51,29 @@ struct FluidModel
 
 	void AddDensity(s32 x, s32 y, f32 amount)
 	{
-		density[idx(x, y)] += amount;
+		density[idx(x, y, size)] += amount;
 	}
 
 	void AddVelocity(s32 x, s32 y, f32 amountX, f32 amountY)
 	{
-		vx[idx(x, y)] += amountX;
-		vy[idx(x, y)] += amountY;
+		vx[idx(x, y, size)] += amountX;
+		vy[idx(x, y, size)] += amountY;
 	}
 
 	void Simulate(f32 dt)
 	{
-		diffuse(1, vx0, vx, visc, dt, 4, N);
-		diffuse(2, vy0, vy, visc, dt, 4, N);
+		diffuse(1, vx0, vx, visc, dt, 4, size);
+		diffuse(2, vy0, vy, visc, dt, 4, size);
 
-		project(vx0, vy0, vx, vy, 4, N);
+		project(vx0, vy0, vx, vy, 4, size);
 
-		advect(1, vx, vx0, vx0, vy0, dt, N);
-		advect(2, vy, vy0, vx0, vy0, dt, N);
+		advect(1, vx, vx0, vx0, vy0, dt, size);
+		advect(2, vy, vy0, vx0, vy0, dt, size);
 
-		project(vx, vy, vx0, vy0, 4, N);
+		project(vx, vy, vx0, vy0, 4, size);
 
-		diffuse(0, s, density, diff, dt, 4, N);
-		advect(0, density, s, vx, vy, dt, N);
+		diffuse(0, s, density, diff, dt, 4, size);
+		advect(0, density, s, vx, vy, dt, size);
 	}
 };
 
@@ -80,20 +82,20 @@ static void set_bnd(s32 b, std::vector<f32>& x, s32 N)
 {
 	for (s32 i = 1; i < N - 1; i++)
 	{
-		x[idx(i, 0)]     = b == 2 ? -x[idx(i, 1)] : x[idx(i, 1)];
-		x[idx(i, N - 1)] = b == 2 ? -x[idx(i, N - 2)] : x[idx(i, N - 2)];
+		x[idx(i, 0, N)]     = b == 2 ? -x[idx(i, 1, N)] : x[idx(i, 1, N)];
+		x[idx(i, N - 1, N)] = b == 2 ? -x[idx(i, N - 2, N)] : x[idx(i, N - 2, N)];
 	}
 
 	for (s32 j = 1; j < N - 1; j++)
 	{
-		x[idx(0, j)]     = b == 1 ? -x[idx(1, j)] : x[idx(1, j)];
-		x[idx(N - 1, j)] = b == 1 ? -x[idx(N - 2, j)] : x[idx(N - 2, j)];
+		x[idx(0, j, N)]     = b == 1 ? -x[idx(1, j, N)] : x[idx(1, j, N)];
+		x[idx(N - 1, j, N)] = b == 1 ? -x[idx(N - 2, j, N)] : x[idx(N - 2, j, N)];
 	}
 
-	x[idx(0, 0)]         = 0.5f * (x[idx(1, 0)]         + x[idx(0, 1)]);
-	x[idx(0, N - 1)]     = 0.5f * (x[idx(1, N - 1)]     + x[idx(0, N - 2)]);
-	x[idx(N - 1, 0)]     = 0.5f * (x[idx(N - 2, 0)]     + x[idx(N - 1, 1)]);
-	x[idx(N - 1, N - 1)] = 0.5f * (x[idx(N - 2, N - 1)] + x[idx(N - 1, N - 2)]);
+	x[idx(0, 0, N)]         = 0.5f * (x[idx(1, 0, N)]         + x[idx(0, 1, N)]);
+	x[idx(0, N - 1, N)]     = 0.5f * (x[idx(1, N - 1, N)]     + x[idx(0, N - 2, N)]);
+	x[idx(N - 1, 0, N)]     = 0.5f * (x[idx(N - 2, 0, N)]     + x[idx(N - 1, 1, N)]);
+	x[idx(N - 1, N - 1, N)] = 0.5f * (x[idx(N - 2, N - 1, N)] + x[idx(N - 1, N - 2, N)]);
 }
 
 // Linear Equation Solver
@@ -106,7 +108,7 @@ static void lin_solve(s32 b, std::vector<f32>& x, std::vector<f32>& x0, f32 a, f
 		{
 			for (s32 i = 1; i < N - 1; i++)
 			{
-				x[idx(i, j)] = (x0[idx(i, j)] + a * (x[idx(i + 1, j)] + x[idx(i - 1, j)] + x[idx(i, j + 1)] + x[idx(i, j - 1)])) * cRecip;
+				x[idx(i, j, N)] = (x0[idx(i, j, N)] + a * (x[idx(i + 1, j, N)] + x[idx(i - 1, j, N)] + x[idx(i, j + 1, N)] + x[idx(i, j - 1, N)])) * cRecip;
 			}
 		}
 
@@ -128,8 +130,8 @@ static void project(std::vector<f32>& vx, std::vector<f32>& vy, std::vector<f32>
 	{
 		for (s32 i = 1; i < N - 1; i++) 
 		{
-			div[idx(i, j)] = (-0.5f * (vx[idx(i + 1, j)] - vx[idx(i - 1, j)] + vy[idx(i, j + 1)] - vy[idx(i, j - 1)])) / N;
-			p[idx(i, j)] = 0;
+			div[idx(i, j, N)] = (-0.5f * (vx[idx(i + 1, j, N)] - vx[idx(i - 1, j, N)] + vy[idx(i, j + 1, N)] - vy[idx(i, j - 1, N)])) / N;
+			p[idx(i, j, N)] = 0;
 		}
 	}
 
@@ -141,8 +143,8 @@ static void project(std::vector<f32>& vx, std::vector<f32>& vy, std::vector<f32>
 	{
 		for (s32 i = 1; i < N - 1; i++) 
 		{
-			vx[idx(i, j)] -= 0.5f * (p[idx(i + 1, j)] - p[idx(i - 1, j)]) * N;
-			vy[idx(i, j)] -= 0.5f * (p[idx(i, j + 1)] - p[idx(i, j - 1)]) * N;
+			vx[idx(i, j, N)] -= 0.5f * (p[idx(i + 1, j, N)] - p[idx(i - 1, j, N)]) * N;
+			vy[idx(i, j, N)] -= 0.5f * (p[idx(i, j + 1, N)] - p[idx(i, j - 1, N)]) * N;
 		}
 	}
 
@@ -169,8 +171,8 @@ static void advect(s32 b, std::vector<f32>& d, std::vector<f32>& d0, std::vector
 	{
 		for (i = 1, ifloat = 1; i < N - 1; i++, ifloat++) 
 		{
-			tmp1 = dtx * vx[idx(i, j)];
-			tmp2 = dty * vy[idx(i, j)];
+			tmp1 = dtx * vx[idx(i, j, N)];
+			tmp2 = dty * vy[idx(i, j, N)];
 			x = ifloat - tmp1;
 			y = jfloat - tmp2;
 
@@ -193,7 +195,7 @@ static void advect(s32 b, std::vector<f32>& d, std::vector<f32>& d0, std::vector
 			s32 j0i = j0;
 			s32 j1i = j1;
 
-			d[idx(i, j)] = s0 * (t0 * d0[idx(i0i, j0i)] + t1 * d0[idx(i0i, j1i)]) + s1 * (t0 * d0[idx(i1i, j0i)] + t1 * d0[idx(i1i, j1i)]);
+			d[idx(i, j, N)] = s0 * (t0 * d0[idx(i0i, j0i, N)] + t1 * d0[idx(i0i, j1i, N)]) + s1 * (t0 * d0[idx(i1i, j0i, N)] + t1 * d0[idx(i1i, j1i, N)]);
 		}
 	}
 
@@ -236,7 +238,7 @@ static std::vector<Color> viridis = {
 	{ 239, 229, 28 }, { 244, 230, 30 }, { 248, 230, 33 }, { 253, 231, 37 }
 };
 
-static Color GetColor(f32 val, f32 min, f32 max)
+inline Color GetColor(f32 val, f32 min, f32 max)
 {
 	f32 v = std::min(std::max(val, min), max);
 	f32 d = max - min;
@@ -0,0 +1,502 @@
+/*
+	Deep Zoom
+		Perturbation rendering past the ~1e-6 limit of 32-bit float.
+
+		One reference point of the view is iterated on the CPU in fixed
+		point with as many bits as the zoom needs (BigFixed). Every pixel
+		then only iterates its small difference delta from that orbit:
+			z = Z + delta
+			delta' = 2 Z delta + delta^2 + dc      (Mandelbrot, dc = c - C)
+			delta' = 2 Z delta + delta^2           (Julia, delta_0 = z_0 - Z_0)
+		which stays accurate in float because only Z needs to be stored,
+		rounded, in the orbit texture.
+
+		Below ~1e-38 delta itself does not fit a float. The shader keeps it
+		as a mantissa and a binary exponent and drops the square term,
+		which is far below the mantissa's precision, until delta grows
+		into float range. When the pixel's orbit comes closer to the orbit
+		start Z_0 than to the reference, or the reference escaped first,
+		delta is rebased onto Z_0, so no second reference is needed.
+
+		Series approximation skips the first iterations of every pixel:
+			delta_n = A_n delta_0 + B_n delta_0^2 + C_n delta_0^3
+		The coefficients are iterated alongside the reference orbit. At a
+		given view the longest prefix whose cubic term is still below float
+		precision relative to the linear one is skipped. The coefficients
+		outgrow double range at deep zooms and are kept as ComplexExp.
+
+		The reference is computed on a worker thread and replaces the
+		previous one when done. The old one keeps rendering meanwhile, it
+		is valid for any view near it.
+*/
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include "Core/Common.h"
+
+/*
+	Signed fixed point number, limb 0 is the integer part and every
+	further limb 32 more fraction bits. Precision is chosen per value,
+	operations use the larger of both operands.
+*/
+class BigFixed
+{
+public:
+	static constexpr s32 MAX_LIMBS = 40; // 1248 fraction bits, zooms to ~1e-370
+
+	BigFixed(s32 limbs = 2) : m_count(std::clamp(limbs, 2, MAX_LIMBS)) {}
+
+	// value * 2^exponent, truncated to the precision, |value * 2^exponent| < 2^32
+	static BigFixed FromDouble(f64 value, s32 limbs, s32 exponent = 0)
+	{
+		BigFixed r(limbs);
+		if (value == 0.0 || !std::isfinite(value))
+			return r;
+
+		r.m_negative = value < 0.0;
+		s32 e = 0;
+		f64 m = std::frexp(std::abs(value), &e);
+		u64 mantissa = static_cast<u64>(std::ldexp(m, 53));
+
+		// Bit b of the mantissa weighs 2^(e + exponent - 53 + b)
+		for (s32 b = 0; b < 53; b++)
+		{
+			if (((mantissa >> b) & 1) == 0)
+				continue;
+			s32 q = e + exponent - 53 + b;
+			if (q > 31)
+				continue;
+			s32 limb = q >= 0 ? 0 : (31 - q) / 32;
+			if (limb >= r.m_count)
+				continue;
+			r.m_limbs[limb] |= 1u << (q + 32 * limb);
+		}
+		return r;
+	}
+
+	// value * 2^exponent, exact in range even when value itself underflows a double
+	f64 ToDouble(s32 exponent = 0) const
+	{
+		f64 v = 0.0;
+		for (s32 i = 0; i < m_count; i++)
+		{
+			if (m_limbs[i] == 0)
+				continue;
+			for (s32 j = i; j < std::min(i + 3, m_count); j++)
+				v += std::ldexp(static_cast<f64>(m_limbs[j]), exponent - 32 * j);
+			break;
+		}
+		return m_negative ? -v : v;
+	}
+
+	// Changes precision, extra limbs are zero
+	void Resize(s32 limbs)
+	{
+		limbs = std::clamp(limbs, 2, MAX_LIMBS);
+		for (s32 i = limbs; i < m_count; i++)
+			m_limbs[i] = 0;
+		m_count = limbs;
+	}
+
+	s32 Limbs() const { return m_count; }
+
+	friend BigFixed operator-(BigFixed a)
+	{
+		a.m_negative = !a.m_negative;
+		return a;
+	}
+
+	friend BigFixed operator+(const BigFixed& a, const BigFixed& b)
+	{
+		BigFixed r(std::max(a.m_count, b.m_count));
+		if (a.m_negative == b.m_negative)
+		{
+			Add(a.m_limbs.data(), b.m_limbs.data(), r.m_limbs.data(), r.m_count);
+			r.m_negative = a.m_negative;
+		}
+		else if (Compare(a.m_limbs.data(), b.m_limbs.data(), r.m_count) >= 0)
+		{
+			Subtract(a.m_limbs.data(), b.m_limbs.data(), r.m_limbs.data(), r.m_count);
+			r.m_negative = a.m_negative;
+		}
+		else
+		{
+			Subtract(b.m_limbs.data(), a.m_limbs.data(), r.m_limbs.data(), r.m_count);
+			r.m_negative = b.m_negative;
+		}
+		return r;
+	}
+
+	friend BigFixed operator-(const BigFixed& a, const BigFixed& b) { return a + -b; }
+
+	// Truncated schoolbook product, columns below the precision only feed their carry
+	friend BigFixed operator*(const BigFixed& a, const BigFixed& b)
+	{
+		s32 n = std::max(a.m_count, b.m_count);
+		BigFixed r(n);
+		r.m_negative = a.m_negative != b.m_negative;
+
+		// 32-bit halves summed per column, at most 2 * MAX_LIMBS of them fit a u64
+		std::array<u64, MAX_LIMBS + 1> column = {};
+		for (s32 i = 0; i < n; i++)
+		{
+			u64 ai = a.m_limbs[i];
+			if (ai == 0)
+				continue;
+			for (s32 j = 0; j < n && i + j <= n; j++)
+			{
+				u64 p = ai * b.m_limbs[j];
+				s32 k = i + j;
+				column[k] += p & 0xFFFFFFFFull;
+				if (k > 0)
+					column[k - 1] += p >> 32;
+			}
+		}
+
+		u64 carry = 0;
+		for (s32 k = n; k >= 0; k--)
+		{
+			u64 v = column[k] + carry;
+			if (k < n)
+				r.m_limbs[k] = static_cast<u32>(v);
+			carry = v >> 32;
+		}
+		return r;
+	}
+
+private:
+	static void Add(const u32* a, const u32* b, u32* r, s32 n)
+	{
+		u64 carry = 0;
+		for (s32 k = n - 1; k >= 0; k--)
+		{
+			u64 v = static_cast<u64>(a[k]) + b[k] + carry;
+			r[k] = static_cast<u32>(v);
+			carry = v >> 32;
+		}
+	}
+
+	// a >= b
+	static void Subtract(const u32* a, const u32* b, u32* r, s32 n)
+	{
+		s64 borrow = 0;
+		for (s32 k = n - 1; k >= 0; k--)
+		{
+			s64 v = static_cast<s64>(a[k]) - b[k] - borrow;
+			borrow = v < 0;
+			r[k] = static_cast<u32>(v + (borrow << 32));
+		}
+	}
+
+	static s32 Compare(const u32* a, const u32* b, s32 n)
+	{
+		for (s32 k = 0; k < n; k++)
+			if (a[k] != b[k])
+				return a[k] < b[k] ? -1 : 1;
+		return 0;
+	}
+
+private:
+	std::array<u32, MAX_LIMBS> m_limbs = {};
+	s32 m_count = 2;
+	bool m_negative = false;
+};
+
+// Complex number (re, im) * 2^exp with the larger mantissa in [0.5, 1)
+struct ComplexExp
+{
+	f64 re = 0.0;
+	f64 im = 0.0;
+	s64 exp = 0;
+
+	ComplexExp() = default;
+	ComplexExp(f64 r, f64 i, s64 e = 0) : re(r), im(i), exp(e) { Normalize(); }
+
+	void Normalize()
+	{
+		f64 m = std::max(std::abs(re), std::abs(im));
+		if (m == 0.0)
+		{
+			exp = 0;
+			return;
+		}
+		s32 e = 0;
+		std::frexp(m, &e);
+		re = std::ldexp(re, -e);
+		im = std::ldexp(im, -e);
+		exp += e;
+	}
+
+	// -inf for zero
+	f64 Log2Magnitude() const { return std::log2(std::hypot(re, im)) + static_cast<f64>(exp); }
+
+	friend ComplexExp operator*(const ComplexExp& a, const ComplexExp& b)
+	{
+		return ComplexExp(a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re, a.exp + b.exp);
+	}
+
+	friend ComplexExp operator+(const ComplexExp& a, const ComplexExp& b)
+	{
+		if (a.re == 0.0 && a.im == 0.0) return b;
+		if (b.re == 0.0 && b.im == 0.0) return a;
+
+		// Exponents past 1100 apart leave the smaller one below double precision
+		s64 e = std::max(a.exp, b.exp);
+		s32 sa = static_cast<s32>(std::max<s64>(a.exp - e, -1100));
+		s32 sb = static_cast<s32>(std::max<s64>(b.exp - e, -1100));
+		return ComplexExp(std::ldexp(a.re, sa) + std::ldexp(b.re, sb), std::ldexp(a.im, sa) + std::ldexp(b.im, sb), e);
+	}
+};
+
+struct ReferenceRequest
+{
+	BigFixed x, y;         // Reference point, z_0 for Julia, c for Mandelbrot
+	f64 zoom_log2 = 0.0;   // View the precision is chosen for
+	s32 max_iter = 0;
+	bool julia = false;
+	f64 cx = 0.0, cy = 0.0; // Julia constant
+};
+
+struct ReferenceOrbit
+{
+	ReferenceRequest request;
+	bool escaped = false;
+
+	// Z_0 .. Z_n interleaved re, im, the last one escaped when escaped
+	std::vector<f64> z;
+
+	// Series coefficients for delta_n, unscaled, one per orbit entry
+	std::vector<ComplexExp> a, b, c;
+	std::vector<f64> log2_a, log2_b, log2_c;
+
+	u32 Length() const { return static_cast<u32>(z.size() / 2); }
+};
+
+// Skip of the series approximation at one view, coefficients scaled to delta_0 = 2^scale_exp u
+struct SeriesApproximation
+{
+	s32 skip = 0;
+	ComplexExp a, b, c;
+};
+
+// Fraction bits the orbit needs at a zoom, 64 bits past the pixel spacing
+inline s32 ReferenceLimbs(f64 zoom_log2)
+{
+	s32 bits = static_cast<s32>(std::max(0.0, -zoom_log2)) + 64;
+	return std::min(BigFixed::MAX_LIMBS, 1 + (bits + 31) / 32);
+}
+
+/*
+	Reference orbit with series coefficients, stops at escape (|Z|^2 > 32,
+	as in fractal.fs), at max_iter or when cancel() turns true.
+*/
+template <typename Cancel>
+bool ComputeReference(const ReferenceRequest& request, ReferenceOrbit& orbit, Cancel&& cancel)
+{
+	s32 limbs = ReferenceLimbs(request.zoom_log2);
+	BigFixed x = request.x, y = request.y;
+	x.Resize(limbs);
+	y.Resize(limbs);
+
+	BigFixed cx = request.julia ? BigFixed::FromDouble(request.cx, limbs) : x;
+	BigFixed cy = request.julia ? BigFixed::FromDouble(request.cy, limbs) : y;
+	if (!request.julia)
+	{
+		// Mandelbrot orbits start at 0
+		x = BigFixed(limbs);
+		y = BigFixed(limbs);
+	}
+
+	orbit = ReferenceOrbit();
+	orbit.request = request;
+	size_t capacity = static_cast<size_t>(request.max_iter) + 1;
+	orbit.z.reserve(capacity * 2);
+	for (std::vector<ComplexExp>* v : { &orbit.a, &orbit.b, &orbit.c }) v->reserve(capacity);
+	for (std::vector<f64>* v : { &orbit.log2_a, &orbit.log2_b, &orbit.log2_c }) v->reserve(capacity);
+
+	// delta_0 is the pixel offset itself for Julia, the Mandelbrot one starts at 0
+	ComplexExp a = request.julia ? ComplexExp(1.0, 0.0) : ComplexExp();
+	ComplexExp b, c;
+	const ComplexExp one(request.julia ? 0.0 : 1.0, 0.0);
+	const ComplexExp two(2.0, 0.0);
+
+	for (s32 n = 0; ; n++)
+	{
+		f64 zx = x.ToDouble(), zy = y.ToDouble();
+		orbit.z.push_back(zx);
+		orbit.z.push_back(zy);
+		orbit.a.push_back(a);
+		orbit.b.push_back(b);
+		orbit.c.push_back(c);
+		orbit.log2_a.push_back(a.Log2Magnitude());
+		orbit.log2_b.push_back(b.Log2Magnitude());
+		orbit.log2_c.push_back(c.Log2Magnitude());
+
+		if (zx * zx + zy * zy > 32.0)
+		{
+			orbit.escaped = true;
+			break;
+		}
+		if (n >= request.max_iter)
+			break;
+		if ((n & 1023) == 0 && cancel())
+			return false;
+
+		// Coefficients of delta_{n+1} from Z_n
+		ComplexExp z2 = two * ComplexExp(zx, zy);
+		ComplexExp next_a = z2 * a + one;
+		ComplexExp next_b = z2 * b + a * a;
+		ComplexExp next_c = z2 * c + two * a * b;
+		a = next_a;
+		b = next_b;
+		c = next_c;
+
+		// z^2 + c
+		BigFixed xy = x * y;
+		BigFixed xx = x * x;
+		BigFixed yy = y * y;
+		x = xx - yy + cx;
+		y = xy + xy + cy;
+	}
+	return true;
+}
+
+/*
+	Longest prefix the series can skip for pixels with |u| <= radius,
+	delta_0 = 2^scale_exp u. The cubic term must stay 2^-24 below the
+	linear one and the quadratic below it.
+*/
+inline SeriesApproximation ApproximateSeries(const ReferenceOrbit& orbit, s32 scale_exp, f64 radius, s32 max_iter)
+{
+	SeriesApproximation series;
+	if (orbit.Length() < 3 || radius <= 0.0)
+		return series;
+
+	f64 r = std::log2(radius);
+	f64 s = static_cast<f64>(scale_exp);
+
+	// Never the last entries, pixels must still be able to see the reference escape
+	s32 last = std::min<s32>(static_cast<s32>(orbit.Length()) - 2, max_iter - 1);
+	s32 skip = 0;
+	for (s32 n = 1; n <= last; n++)
+	{
+		f64 t1 = orbit.log2_a[n] + s + r;
+		f64 t2 = orbit.log2_b[n] + 2.0 * (s + r);
+		f64 t3 = orbit.log2_c[n] + 3.0 * (s + r);
+		if (!(t3 < t1 - 24.0 && t2 < t1))
+			break;
+		skip = n;
+	}
+
+	if (skip == 0)
+		return series;
+
+	series.skip = skip;
+	series.a = orbit.a[skip];
+	series.b = orbit.b[skip];
+	series.c = orbit.c[skip];
+	series.a.exp += scale_exp;
+	series.b.exp += 2 * static_cast<s64>(scale_exp);
+	series.c.exp += 3 * static_cast<s64>(scale_exp);
+	return series;
+}
+
+// Computes reference orbits off the render thread, a newer request cancels the running one
+class ReferenceWorker
+{
+public:
+	ReferenceWorker() : m_thread(&ReferenceWorker::Run, this) {}
+
+	~ReferenceWorker()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+			m_generation++;
+		}
+		m_wake.notify_one();
+		m_thread.join();
+	}
+
+	ReferenceWorker(const ReferenceWorker&) = delete;
+	ReferenceWorker& operator=(const ReferenceWorker&) = delete;
+
+public:
+	void Request(const ReferenceRequest& request)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_request = request;
+			m_pending = true;
+
+			// Under the lock, a worker taking this request must see its generation
+			m_generation++;
+		}
+		m_wake.notify_one();
+	}
+
+	// Render thread, moves a finished orbit into orbit
+	bool Poll(ReferenceOrbit& orbit)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_ready)
+			return false;
+		orbit = std::move(m_result);
+		m_ready = false;
+		return true;
+	}
+
+	bool Busy() const { return m_busy.load(std::memory_order_relaxed); }
+
+private:
+	void Run()
+	{
+		ReferenceOrbit orbit;
+		while (true)
+		{
+			ReferenceRequest request;
+			u64 generation = 0;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [this] { return m_pending || m_quit; });
+				if (m_quit)
+					return;
+				request = m_request;
+				m_pending = false;
+				generation = m_generation.load();
+			}
+
+			m_busy = true;
+			bool done = ComputeReference(request, orbit, [&] { return m_generation.load(std::memory_order_relaxed) != generation; });
+			m_busy = false;
+
+			if (done)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_result = std::move(orbit);
+				m_ready = true;
+			}
+		}
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	ReferenceRequest m_request;
+	ReferenceOrbit m_result;
+	bool m_pending = false;
+	bool m_ready = false;
+	bool m_quit = false;
+
+	std::atomic<u64> m_generation = 0;
+	std::atomic<bool> m_busy = false;
+	std::thread m_thread;
+};
@@ -2,6 +2,8 @@
 	Fractal Explorer
 		Mandelbrot Shader
 		Julia Shader
+		Deep Zoom (perturbation past 1e-6, see deep_zoom.h)
+		Progressive Rendering (tiles over several frames, see progressive.h)
 
 	https://paulbourke.net/fractals/juliaset/
 	https://www.karlsims.com/julia.html
@@ -11,9 +13,14 @@
 
 #include "Graphics/Sprite.h"
 #include "Graphics/Shader.h"
+#include "Graphics/PostProcessor.h"
+#include "Graphics/RenderState.h"
 
 #include "Core/Random.h"
 
+#include "deep_zoom.h"
+#include "progressive.h"
+
 class Fractal : public Application
 {
 public:
@@ -22,6 +29,8 @@ public:
 public:
 	std::unique_ptr<Sprite> sprite;
 	std::unique_ptr<Shader> fractal_shader;
+	std::unique_ptr<Shader> texture_shader;
+	std::unique_ptr<PostProcessor> post_processor;
 	bool show_julia = true;
 
 	// Beautiful julia constants
@@ -47,11 +56,62 @@ public:
 	f32 timer = 0.0f;
 	f32 ping_pong_interval = 5.0f;
 
+	// Deep zoom, the view center is kept in fixed point below the float limit
+	static constexpr f32 DEEP_ENTER = 1e-6f;
+	static constexpr f32 DEEP_EXIT  = 1e-5f;
+	static constexpr s32 ORBIT_WIDTH = 4096; // deep_zoom.fs
+	std::unique_ptr<Shader> deep_shader;
+	bool deep_zoom = false;
+	BigFixed deep_x, deep_y; // c for Mandelbrot, z for Julia
+	f64 zoom_log2 = 0.0;
+	ReferenceWorker reference_worker;
+	ReferenceOrbit reference;
+	bool reference_valid = false;
+	bool reference_pending = false;
+	u32 orbit_texture = 0;
+	s32 orbit_rows = 0;
+	SeriesApproximation series;
+	u32 reference_serial = 0; // Orbits received
+
+	// Progressive rendering, pans snap to whole pixels so the image can be kept
+	struct ViewKey
+	{
+		bool julia = false;
+		bool deep = false;
+		vf2 c = {};
+		s32 max_iter = 0;
+		f32 zoom = 0.0f;
+		f64 zoom_log2 = 0.0;
+		u32 reference = 0;
+
+		bool operator==(const ViewKey&) const = default;
+	};
+	std::unique_ptr<ProgressiveRenderer> progressive;
+	ViewKey drawn_key;
+	vf2 drawn_center = { 0.0f, 0.0f };
+	BigFixed drawn_x, drawn_y;
+
 	void Create() override
 	{
 		screen_size    = { m_window.Width(), m_window.Height() };
 		sprite         = std::make_unique<Sprite>(screen_size.x, screen_size.y);
 		fractal_shader = std::make_unique<Shader>("res/shaders/fractal/fractal.vs", "res/shaders/fractal/fractal.fs");
+		texture_shader = std::make_unique<Shader>("res/shaders/basic/texture.vs", "res/shaders/basic/texture.fs");
+		deep_shader    = std::make_unique<Shader>("res/shaders/fractal/fractal.vs", "res/shaders/fractal/deep_zoom.fs");
+
+		// Iteration count drives the cost, trade resolution for frame rate
+		post_processor = std::make_unique<PostProcessor>(m_window.Width(), m_window.Height());
+		post_processor->Resolution().enabled = true;
+		post_processor->Resolution().target_ms = 12.0f;
+
+		progressive = std::make_unique<ProgressiveRenderer>(m_window.Width(), m_window.Height());
+
+		// Both follow GPU timings, offline frames must be complete and identical between runs
+		if (s_offline.enabled)
+		{
+			progressive->Settings().enabled = false;
+			post_processor->Resolution().enabled = false;
+		}
 	}
 
 	void ProcessInput() override
@@ -62,7 +122,10 @@ public:
 
 		// Reset
 		if (m_input.IsKeyPressed(GLFW_KEY_R))
+		{
 			zoom = 0.9f;
+			deep_zoom = false;
+		}
 
 		// Animate
 		if (m_input.IsKeyPressed(GLFW_KEY_SPACE))
@@ -72,8 +135,16 @@ public:
 		if (m_input.IsButtonPressed(1))
 		{
 			vf2 delta = m_input.GetMouseDelta();
-			center_offset.x -= delta.x * -pan_sensitivity * zoom;
-			center_offset.y += delta.y * -pan_sensitivity * zoom;
+			if (deep_zoom)
+			{
+				deep_x = deep_x + DeepOffset(delta.x * pan_sensitivity);
+				deep_y = deep_y - DeepOffset(delta.y * pan_sensitivity);
+			}
+			else
+			{
+				center_offset.x -= delta.x * -pan_sensitivity * zoom;
+				center_offset.y += delta.y * -pan_sensitivity * zoom;
+			}
 		}
 
 		// Zoom
@@ -86,9 +157,19 @@ public:
 			mouse_ndc.x *= aspect_ratio;
 			mouse_ndc.y = -mouse_ndc.y;
 
+			// Past the float limit the view continues in fixed point
+			f32 zoom_factor = std::exp(-wheel_delta * zoom_sensitivity);
+			if (!deep_zoom && zoom * zoom_factor < DEEP_ENTER)
+				EnterDeepZoom();
+
+			if (deep_zoom)
+			{
+				ZoomDeep(mouse_ndc, std::log2(zoom_factor));
+				return;
+			}
+
 			vf2 before_zoom = mouse_ndc * zoom + center_offset;
 
-			f32 zoom_factor = std::exp(-wheel_delta * zoom_sensitivity);
 			zoom = std::clamp(zoom * zoom_factor, 1e-6f, 2.0f);
 
 			vf2 after_zoom = mouse_ndc * zoom + center_offset;
@@ -96,7 +177,183 @@ public:
 			center_offset += before_zoom - after_zoom;
 		}
 	}
+
+	// ndc distance at the current zoom as a fixed point offset
+	BigFixed DeepOffset(f64 ndc) const
+	{
+		s32 exponent = static_cast<s32>(std::floor(zoom_log2));
+		return BigFixed::FromDouble(ndc * std::exp2(zoom_log2 - exponent), deep_x.Limbs(), exponent);
+	}
+
+	void EnterDeepZoom()
+	{
+		zoom_log2 = std::log2(zoom);
+		s32 limbs = ReferenceLimbs(zoom_log2);
+
+		// fractal.fs shifts the Mandelbrot view by -0.5
+		vf2 center = show_julia ? center_offset : center_offset + vf2(-0.5f, 0.0f);
+		deep_x = BigFixed::FromDouble(center.x, limbs);
+		deep_y = BigFixed::FromDouble(center.y, limbs);
+
+		deep_zoom = true;
+		reference_valid = false;
+	}
+
+	void ExitDeepZoom()
+	{
+		vf2 center = { static_cast<f32>(deep_x.ToDouble()), static_cast<f32>(deep_y.ToDouble()) };
+		center_offset = show_julia ? center : center - vf2(-0.5f, 0.0f);
+		zoom = std::clamp(static_cast<f32>(std::exp2(zoom_log2)), DEEP_ENTER, 2.0f);
+		deep_zoom = false;
+	}
+
+	// Keeps the point under the mouse in place
+	void ZoomDeep(vf2 mouse_ndc, f64 log2_factor)
+	{
+		// 64 fraction bits stay past the pixel spacing at the deepest zoom
+		constexpr f64 min_zoom_log2 = 64.0 - 32.0 * (BigFixed::MAX_LIMBS - 1);
+
+		f64 next_log2 = std::max(zoom_log2 + log2_factor, min_zoom_log2);
+		f64 shift = 1.0 - std::exp2(next_log2 - zoom_log2);
+		deep_x = deep_x + DeepOffset(mouse_ndc.x * shift);
+		deep_y = deep_y + DeepOffset(mouse_ndc.y * shift);
+		zoom_log2 = next_log2;
+
+		s32 limbs = std::max(deep_x.Limbs(), ReferenceLimbs(zoom_log2));
+		deep_x.Resize(limbs);
+		deep_y.Resize(limbs);
+
+		if (zoom_log2 > std::log2(DEEP_EXIT))
+			ExitDeepZoom();
+	}
+
+	// Offset of a view center from the reference in units of 2^floor(zoom_log2)
+	vf2 ReferenceOffset(const BigFixed& x, const BigFixed& y) const
+	{
+		s32 exponent = static_cast<s32>(std::floor(zoom_log2));
+		return {
+			static_cast<f32>((x - reference.request.x).ToDouble(-exponent)),
+			static_cast<f32>((y - reference.request.y).ToDouble(-exponent))
+		};
+	}
+
+	bool ReferenceStale() const
+	{
+		const ReferenceRequest& request = reference.request;
+		if (request.julia != show_julia)
+			return true;
+		if (show_julia && (request.cx != c.x || request.cy != c.y))
+			return true;
+		if (max_iter > request.max_iter && !reference.escaped)
+			return true;
+
+		// Precision runs out 64 bits below the reference zoom, and far
+		// off the reference rebasing would do most of the work
+		if (zoom_log2 < request.zoom_log2 - 32.0)
+			return true;
+		return glm::length(ReferenceOffset(deep_x, deep_y)) > 4.0f;
+	}
+
+	void UpdateReference()
+	{
+		if (reference_worker.Poll(reference))
+		{
+			reference_valid = true;
+			reference_pending = false;
+			reference_serial++;
+			UploadOrbit();
+		}
+
+		if (!reference_pending && (!reference_valid || ReferenceStale()))
+		{
+			ReferenceRequest request;
+			request.x = deep_x;
+			request.y = deep_y;
+			request.zoom_log2 = zoom_log2;
+			request.max_iter = max_iter;
+			request.julia = show_julia;
+			request.cx = c.x;
+			request.cy = c.y;
+			reference_worker.Request(request);
+			reference_pending = true;
+		}
+	}
+
+	void UploadOrbit()
+	{
+		// RG32F rows of ORBIT_WIDTH entries, the float rounding of Z is what the shader sees anyway
+		u32 length = reference.Length();
+		s32 rows = static_cast<s32>((length + ORBIT_WIDTH - 1) / ORBIT_WIDTH);
+		std::vector<f32> texels(static_cast<size_t>(rows) * ORBIT_WIDTH * 2, 0.0f);
+		for (size_t i = 0; i < reference.z.size(); i++)
+			texels[i] = static_cast<f32>(reference.z[i]);
+
+		if (orbit_texture == 0)
+		{
+			glGenTextures(1, &orbit_texture);
+			RenderState::BindTexture(1, orbit_texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		RenderState::BindTexture(1, orbit_texture);
+		if (rows == orbit_rows)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, ORBIT_WIDTH, rows, GL_RG, GL_FLOAT, texels.data());
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, ORBIT_WIDTH, rows, 0, GL_RG, GL_FLOAT, texels.data());
+		orbit_rows = rows;
+	}
 	
+	// Whole pixel pans shift the progressive image, any other change restarts it
+	void SnapView(bool deep)
+	{
+		ViewKey key;
+		key.julia = show_julia;
+		key.deep = deep;
+		key.c = c;
+		key.max_iter = max_iter;
+		key.zoom = deep ? 0.0f : zoom;
+		key.zoom_log2 = deep ? zoom_log2 : 0.0;
+		key.reference = deep ? reference_serial : 0;
+		if (key != drawn_key)
+		{
+			drawn_key = key;
+			drawn_center = center_offset;
+			drawn_x = deep_x;
+			drawn_y = deep_y;
+			progressive->Restart();
+			return;
+		}
+
+		// ndc spans 2 over the screen height, the pixel size in view units follows
+		auto whole_pixels = [](f64 distance, f64 pixel) {
+			return static_cast<s32>(std::clamp(std::round(distance / pixel), -1e6, 1e6));
+		};
+
+		s32 dx = 0, dy = 0;
+		if (deep)
+		{
+			s32 exponent = static_cast<s32>(std::floor(zoom_log2));
+			f64 pixel = 2.0 * std::exp2(zoom_log2 - exponent) / screen_size.y;
+			dx = whole_pixels((deep_x - drawn_x).ToDouble(-exponent), pixel);
+			dy = whole_pixels((deep_y - drawn_y).ToDouble(-exponent), pixel);
+			drawn_x = drawn_x + BigFixed::FromDouble(dx * pixel, drawn_x.Limbs(), exponent);
+			drawn_y = drawn_y + BigFixed::FromDouble(dy * pixel, drawn_y.Limbs(), exponent);
+		}
+		else
+		{
+			f32 pixel = 2.0f * zoom / screen_size.y;
+			dx = whole_pixels(center_offset.x - drawn_center.x, pixel);
+			dy = whole_pixels(center_offset.y - drawn_center.y, pixel);
+			drawn_center += vf2(dx, dy) * pixel;
+		}
+
+		if (dx != 0 || dy != 0)
+			progressive->Shift(dx, dy);
+	}
+
 	void Simulate(f32 dt) override
 	{
 		timer += dt;
@@ -128,25 +385,121 @@ public:
 	{
 		m_window.Clear();
 
-		fractal_shader->Use();
-		fractal_shader->SetUniform("screen_size", screen_size);
-		fractal_shader->SetUniform("zoom", zoom);
-		fractal_shader->SetUniform("max_iter", max_iter);
-		fractal_shader->SetUniform("c", c);
-		fractal_shader->SetUniform("show_julia", show_julia);
-		fractal_shader->SetUniform("center_offset", center_offset);
+		if (deep_zoom)
+			UpdateReference();
+
+		// The float shader stands in until the first reference orbit arrives
+		bool deep = deep_zoom && reference_valid;
+		bool progressive_enabled = progressive->Settings().enabled;
+		if (progressive_enabled)
+		{
+			SnapView(deep);
+		}
+		else
+		{
+			// Restart once progressive rendering is turned back on
+			drawn_key = ViewKey();
+			drawn_center = center_offset;
+			drawn_x = deep_x;
+			drawn_y = deep_y;
+		}
+
+		Shader& shader = deep ? *deep_shader : *fractal_shader;
+		if (deep)
+		{
+			f32 aspect_ratio = screen_size.x / screen_size.y;
+			s32 scale_exp = static_cast<s32>(std::floor(zoom_log2));
+			f32 view = static_cast<f32>(std::exp2(zoom_log2 - scale_exp));
+			vf2 offset = ReferenceOffset(drawn_x, drawn_y);
+
+			// Farthest pixel from the reference bounds the series skip
+			f64 radius = glm::length(offset) + view * std::sqrt(aspect_ratio * aspect_ratio + 1.0f);
+			series = ApproximateSeries(reference, scale_exp, radius, max_iter);
+			s32 series_exp[3] = {
+				static_cast<s32>(series.a.exp), static_cast<s32>(series.b.exp), static_cast<s32>(series.c.exp)
+			};
+
+			RenderState::BindTexture(1, orbit_texture);
+			deep_shader->Use();
+			deep_shader->SetUniform("screen_size", screen_size);
+			deep_shader->SetUniform("max_iter", max_iter);
+			deep_shader->SetUniform("show_julia", show_julia);
+			deep_shader->SetUniform("orbit", 1);
+			deep_shader->SetUniform("orbit_length", static_cast<s32>(reference.Length()));
+			deep_shader->SetUniform("scale_exp", scale_exp);
+			deep_shader->SetUniform("offset", offset);
+			deep_shader->SetUniform("view", view);
+			deep_shader->SetUniform("series_skip", series.skip);
+			deep_shader->SetUniform("series_a", vf2(series.a.re, series.a.im));
+			deep_shader->SetUniform("series_b", vf2(series.b.re, series.b.im));
+			deep_shader->SetUniform("series_c", vf2(series.c.re, series.c.im));
+			deep_shader->SetUniform("series_exp", series_exp, 3);
+		}
+		else
+		{
+			fractal_shader->Use();
+			fractal_shader->SetUniform("screen_size", screen_size);
+			fractal_shader->SetUniform("zoom", zoom);
+			fractal_shader->SetUniform("max_iter", max_iter);
+			fractal_shader->SetUniform("c", c);
+			fractal_shader->SetUniform("show_julia", show_julia);
+			fractal_shader->SetUniform("center_offset", drawn_center);
+		}
 
-		sprite->Draw();
+		if (progressive_enabled)
+		{
+			progressive->Render(shader);
+			progressive->Present();
+		}
+		else
+		{
+			post_processor->Begin();
+			sprite->Draw();
+			post_processor->End();
+
+			texture_shader->Use();
+			texture_shader->SetUniform("screen_texture", 0);
+			post_processor->Render();
+		}
 
 		m_gui.m_func = [&]() {
 			ImGui::Begin("Fractal Parameters");
 
-			ImGui::DragFloat("Zoom", &zoom, 0.01f, 1e-6f, 1.0f);
-			ImGui::DragInt("Max Iteration", &max_iter, 1, 1, 5000);
+			if (deep_zoom)
+			{
+				ImGui::Text("Deep Zoom: 1e%.1f, %d bits", zoom_log2 * std::log10(2.0), 32 * (deep_x.Limbs() - 1));
+				ImGui::Text("Reference: %u iterations%s, series skip %d", reference.Length(), reference_worker.Busy() ? " (computing)" : "", series.skip);
+			}
+			else
+			{
+				ImGui::DragFloat("Zoom", &zoom, 0.01f, DEEP_ENTER, 1.0f);
+			}
+			ImGui::DragInt("Max Iteration", &max_iter, 1, 1, 100000);
+
+			ProgressiveSettings& settings = progressive->Settings();
+			ImGui::Checkbox("Progressive", &settings.enabled);
+			if (settings.enabled)
+			{
+				ImGui::DragFloat("GPU Budget (ms)", &settings.target_ms, 0.1f, 1.0f, 100.0f);
+				ImGui::Text("Progress: %.0f%% (GPU %.2f ms, %.0f px/frame)", progressive->Progress() * 100.0f, progressive->GetGpuTime(), progressive->GetPixelBudget());
+			}
+			else
+			{
+				DynamicResolution& resolution = post_processor->Resolution();
+				ImGui::Checkbox("Dynamic Resolution", &resolution.enabled);
+				ImGui::DragFloat("GPU Budget (ms)", &resolution.target_ms, 0.1f, 1.0f, 100.0f);
+				ImGui::SliderFloat("Sharpness", &resolution.sharpness, 0.0f, 1.0f);
+				ImGui::Text("Render Scale: %.3f (GPU %.2f ms)", post_processor->GetRenderScale(), post_processor->GetGpuTime());
+			}
 			ImGui::DragFloat2("c", glm::value_ptr(c), 0.001f, -1.0f, 1.0f);
 
 			if (ImGui::Button(show_julia ? "Mandelbrot Set" : "Julia Set"))
+			{
+				// The deep center means a different point in the other set
+				if (deep_zoom)
+					ExitDeepZoom();
 				show_julia = !show_julia;
+			}
 
 			ImGui::BeginDisabled(!show_julia);
 			ImGui::Checkbox("Animate", &animate_julia);
@@ -158,6 +511,16 @@ public:
 			ImGui::End();
 		};
 	}
+
+	void Destroy() override
+	{
+		if (orbit_texture != 0)
+		{
+			RenderState::ForgetTexture(orbit_texture);
+			glDeleteTextures(1, &orbit_texture);
+			orbit_texture = 0;
+		}
+	}
 };
 
 int main()
@@ -0,0 +1,282 @@
+/*
+	Progressive Rendering
+		At high iteration counts one full screen draw of the fractal takes
+		longer than a frame, on software GL or a weak GPU long enough to
+		freeze the window or trip the driver watchdog. The view is instead
+		drawn in tiles over several frames into accumulation targets that
+		are composited to the screen every frame.
+
+		Refinement goes coarse to fine: the view is drawn at 1/8, then 1/4,
+		then full resolution, every level in tiles nearest the screen
+		center first. Present() shows each pixel from the finest level
+		that already has it, so the image sharpens in place. Targets are
+		cleared to zero alpha, the fractal shaders write alpha 1.
+
+		Tiles per frame follow a GPU time budget. The measured time per
+		pixel turns the budget into a pixel count for the next frame, at
+		least one tile is drawn. Once every level is complete nothing is
+		drawn until the view changes.
+
+	Panning
+		Shift() moves the full resolution level by whole pixels instead of
+		starting over. A tile is kept when every pixel it now shows came
+		from a complete tile, only the uncovered border is drawn again.
+		Coarse levels are cheap and simply restart.
+*/
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+#include "Graphics/Shader.h"
+#include "Graphics/GpuTimer.h"
+#include "Graphics/RenderState.h"
+#include "Graphics/RenderTarget.h"
+#include "Graphics/TextureQuad.h"
+
+struct ProgressiveSettings
+{
+	bool enabled = true;
+	f32 target_ms = 8.0f; // GPU time per frame spent on tiles
+};
+
+class ProgressiveRenderer
+{
+public:
+	static constexpr s32 TILE_SIZE = 128;
+	static constexpr std::array<s32, 3> LEVEL_DIVISORS = { 8, 4, 1 }; // coarse to fine
+
+	ProgressiveRenderer(s32 width, s32 height) : m_width(width), m_height(height)
+	{
+		for (size_t i = 0; i < LEVEL_DIVISORS.size(); i++)
+		{
+			Level& level = m_levels[i];
+			level.width  = std::max(1, (width  + LEVEL_DIVISORS[i] - 1) / LEVEL_DIVISORS[i]);
+			level.height = std::max(1, (height + LEVEL_DIVISORS[i] - 1) / LEVEL_DIVISORS[i]);
+			level.columns = (level.width  + TILE_SIZE - 1) / TILE_SIZE;
+			level.rows    = (level.height + TILE_SIZE - 1) / TILE_SIZE;
+			level.target = std::make_unique<RenderTarget>(level.width, level.height, GL_RGBA8);
+		}
+
+		// The finest level ping-pongs when shifted
+		m_shifted = std::make_unique<RenderTarget>(m_width, m_height, GL_RGBA8);
+
+		m_quad = std::make_unique<TextureQuad>();
+		m_shift_shader   = std::make_unique<Shader>("res/shaders/fractal/fractal.vs", "res/shaders/fractal/progressive_shift.fs");
+		m_present_shader = std::make_unique<Shader>("res/shaders/fractal/fractal.vs", "res/shaders/fractal/progressive.fs");
+
+		Restart();
+	}
+
+public:
+	// The view changed, every level starts over
+	void Restart()
+	{
+		for (Level& level : m_levels)
+		{
+			Clear(*level.target);
+			level.done.assign(static_cast<size_t>(level.columns) * level.rows, 0);
+			Schedule(level);
+		}
+	}
+
+	// The view moved by whole pixels, +x right and +y up
+	void Shift(s32 dx, s32 dy)
+	{
+		Level& fine = m_levels.back();
+
+		// Pixel p now shows what p + shift showed
+		RenderState::Disable(GL_BLEND);
+		RenderState::Disable(GL_SCISSOR_TEST);
+		m_shifted->Bind();
+		m_shift_shader->Use();
+		m_shift_shader->SetUniform("previous", 0);
+		m_shift_shader->SetUniform("shift", vf2(static_cast<f32>(dx), static_cast<f32>(dy)));
+		RenderState::BindTexture(0, fine.target->texture);
+		m_quad->Draw();
+		std::swap(fine.target, m_shifted);
+
+		// A tile stays done when the tiles its source rectangle overlaps all were
+		std::vector<u8> done(fine.done.size(), 0);
+		for (s32 row = 0; row < fine.rows; row++)
+		{
+			for (s32 column = 0; column < fine.columns; column++)
+			{
+				s32 x0 = column * TILE_SIZE + dx;
+				s32 y0 = row * TILE_SIZE + dy;
+				s32 x1 = std::min((column + 1) * TILE_SIZE, fine.width) + dx - 1;
+				s32 y1 = std::min((row + 1) * TILE_SIZE, fine.height) + dy - 1;
+				if (x0 < 0 || y0 < 0 || x1 >= fine.width || y1 >= fine.height)
+					continue;
+
+				bool kept = true;
+				for (s32 r = y0 / TILE_SIZE; r <= y1 / TILE_SIZE && kept; r++)
+					for (s32 c = x0 / TILE_SIZE; c <= x1 / TILE_SIZE && kept; c++)
+						kept = fine.done[r * fine.columns + c] != 0;
+				done[row * fine.columns + column] = kept;
+			}
+		}
+		fine.done = std::move(done);
+		Schedule(fine);
+
+		for (size_t i = 0; i + 1 < m_levels.size(); i++)
+		{
+			Clear(*m_levels[i].target);
+			m_levels[i].done.assign(m_levels[i].done.size(), 0);
+			Schedule(m_levels[i]);
+		}
+	}
+
+	// Draws pending tiles with shader, its uniforms must be set
+	void Render(Shader& shader)
+	{
+		UpdateBudget();
+		if (Done())
+			return;
+
+		RenderState::Disable(GL_BLEND);
+		RenderState::Disable(GL_DEPTH_TEST);
+		RenderState::Enable(GL_SCISSOR_TEST);
+		shader.Use();
+
+		m_timer.Begin();
+		f32 pixels = 0.0f;
+		for (Level& level : m_levels)
+		{
+			if (level.pending.empty())
+				continue;
+
+			level.target->Bind();
+			while (!level.pending.empty() && (pixels == 0.0f || pixels < m_budget))
+			{
+				s32 tile = level.pending.back();
+				level.pending.pop_back();
+
+				s32 x = (tile % level.columns) * TILE_SIZE;
+				s32 y = (tile / level.columns) * TILE_SIZE;
+				s32 w = std::min(TILE_SIZE, level.width - x);
+				s32 h = std::min(TILE_SIZE, level.height - y);
+				glScissor(x, y, w, h);
+				m_quad->Draw();
+
+				level.done[tile] = 1;
+				pixels += static_cast<f32>(w * h);
+			}
+
+			// Finer levels wait for this one
+			if (!level.pending.empty() || pixels >= m_budget)
+				break;
+		}
+		m_timer.End();
+
+		RenderState::Disable(GL_SCISSOR_TEST);
+		m_pixels = m_pixels > 0.0f ? m_pixels + (pixels - m_pixels) * 0.2f : pixels;
+	}
+
+	// Composites the levels into the default framebuffer
+	void Present()
+	{
+		RenderState::BindFramebuffer(0);
+		glViewport(0, 0, m_width, m_height);
+		RenderState::Disable(GL_BLEND);
+		RenderState::Disable(GL_DEPTH_TEST);
+
+		m_present_shader->Use();
+		for (size_t i = 0; i < m_levels.size(); i++)
+		{
+			std::string sampler = "level" + std::to_string(i);
+			m_present_shader->SetUniform(sampler, static_cast<s32>(i));
+			RenderState::BindTexture(static_cast<u32>(i), m_levels[i].target->texture);
+		}
+		m_quad->Draw();
+	}
+
+	bool Done() const
+	{
+		return std::all_of(m_levels.begin(), m_levels.end(), [](const Level& level) { return level.pending.empty(); });
+	}
+
+	// Finished share of the full resolution level
+	f32 Progress() const
+	{
+		const Level& fine = m_levels.back();
+		return static_cast<f32>(std::count(fine.done.begin(), fine.done.end(), 1)) / static_cast<f32>(fine.done.size());
+	}
+
+	f32 GetGpuTime() const { return m_gpu_ms; }
+	f32 GetPixelBudget() const { return m_budget; }
+	ProgressiveSettings& Settings() { return m_settings; }
+
+private:
+	struct Level
+	{
+		std::unique_ptr<RenderTarget> target;
+		s32 width = 0, height = 0;
+		s32 columns = 0, rows = 0;
+		std::vector<u8> done;
+		std::vector<s32> pending; // Drawn from the back
+	};
+
+	void Clear(RenderTarget& target)
+	{
+		RenderState::Disable(GL_SCISSOR_TEST);
+		target.Bind();
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+
+	// Pending tiles of a level, the one nearest the center last
+	void Schedule(Level& level)
+	{
+		level.pending.clear();
+		for (s32 tile = 0; tile < static_cast<s32>(level.done.size()); tile++)
+			if (!level.done[tile])
+				level.pending.push_back(tile);
+
+		auto distance = [&](s32 tile) {
+			f32 x = ((tile % level.columns) + 0.5f) * TILE_SIZE - level.width  * 0.5f;
+			f32 y = ((tile / level.columns) + 0.5f) * TILE_SIZE - level.height * 0.5f;
+			return x * x + y * y;
+		};
+		std::sort(level.pending.begin(), level.pending.end(), [&](s32 a, s32 b) { return distance(a) > distance(b); });
+	}
+
+	void UpdateBudget()
+	{
+		if (m_timer.Poll())
+		{
+			// Smooth out single slow frames
+			f32 ms = m_timer.Milliseconds();
+			m_gpu_ms = m_gpu_ms > 0.0f ? m_gpu_ms + (ms - m_gpu_ms) * 0.2f : ms;
+		}
+		if (m_gpu_ms <= 0.0f || m_pixels <= 0.0f)
+			return;
+
+		// Timings lag a few frames, grow at most twofold per frame to not overshoot
+		f32 ms_per_pixel = m_gpu_ms / m_pixels;
+		f32 budget = m_settings.target_ms / std::max(ms_per_pixel, 1e-9f);
+		m_budget = std::min(budget, std::max(m_budget, static_cast<f32>(TILE_SIZE * TILE_SIZE)) * 2.0f);
+	}
+
+private:
+	s32 m_width;
+	s32 m_height;
+	std::array<Level, LEVEL_DIVISORS.size()> m_levels;
+	std::unique_ptr<RenderTarget> m_shifted;
+
+	std::unique_ptr<TextureQuad> m_quad;
+	std::unique_ptr<Shader> m_shift_shader;
+	std::unique_ptr<Shader> m_present_shader;
+
+	ProgressiveSettings m_settings;
+	GpuTimer m_timer;
+	f32 m_gpu_ms = 0.0f;
+	f32 m_pixels = 0.0f;   // Smoothed pixels drawn per frame
+	f32 m_budget = 0.0f;   // Pixels to draw this frame, 0 draws a single tile
+};
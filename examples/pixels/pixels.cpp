@@ -16,7 +16,9 @@ public:
 public:
 	std::unique_ptr<Sprite> sprite;
 	std::unique_ptr<Shader> texture_shader;
-	Random rng;
+	CounterRandom rng;
+	std::vector<u8> noise;
+	u64 frame = 0;
 	s32 scale = 4;
 
 	void Create() override
@@ -33,13 +35,20 @@ public:
 
 	void Simulate(f32 dt) override
 	{
+		// Frame is the stream, one bulk draw for all channels, every
+		// Philox block covers five pixels and any range can be drawn on
+		// any thread in any order
+		noise.resize(3 * m_window.Width() * m_window.Height());
+		rng.fork(frame++).fill_bytes(noise);
+
 		for (s32 x = 0; x < m_window.Width(); x++)
 		{
 			for (s32 y = 0; y < m_window.Height(); y++)
 			{
-				u8 r = rng.uniformi(0, 255);
-				u8 g = rng.uniformi(0, 255);
-				u8 b = rng.uniformi(0, 255);
+				const u8* rgb = &noise[3 * (y * m_window.Width() + x)];
+				u8 r = rgb[0];
+				u8 g = rgb[1];
+				u8 b = rgb[2];
 
 				s32 sx = x * scale;
 				s32 sy = y * scale;
@@ -2,18 +2,88 @@
 
 Application::Application()
 {
+    // Runs before the derived class members, seeds their Random instances
+    if (const char* spec = std::getenv("GLT_OFFLINE"))
+    {
+        OfflineSettings settings;
+        settings.enabled = true;
+        if (ParseOffline(spec, settings))
+            SetOffline(settings);
+    }
+}
 
+void Application::SetOffline(const OfflineSettings& settings)
+{
+    s_offline = settings;
+    Random::SetDefaultSeed(settings.enabled ? std::optional<u64>(settings.seed) : std::nullopt);
+}
+
+bool Application::ParseOffline(const std::string& spec, OfflineSettings& settings)
+{
+    // Space separated key=value pairs
+    size_t start = 0;
+    while (start < spec.size())
+    {
+        size_t end = spec.find(' ', start);
+        if (end == std::string::npos)
+            end = spec.size();
+
+        std::string token = spec.substr(start, end - start);
+        start = end + 1;
+        if (token.empty())
+            continue;
+
+        size_t eq = token.find('=');
+        std::string key   = token.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : token.substr(eq + 1);
+
+        try
+        {
+            if      (key == "frames")  settings.frames = static_cast<u32>(std::stoul(value));
+            else if (key == "dt")      settings.dt     = std::stof(value);
+            else if (key == "fps")     settings.dt     = 1.0f / std::stof(value);
+            else if (key == "seed")    settings.seed   = std::stoull(value);
+            else if (key == "hidden")  settings.hidden = value != "0";
+            else if (key == "capture")
+            {
+                settings.capture = value == "png" || value == "video";
+                settings.capture_format = value == "video" ? CAPTURE_VIDEO : CAPTURE_PNG;
+            }
+            else
+            {
+                std::printf("WARNING: Unknown offline option '%s'\n", key.c_str());
+            }
+        }
+        catch (const std::exception&)
+        {
+            std::printf("ERROR: Invalid offline option '%s'\n", token.c_str());
+            return false;
+        }
+    }
+    return true;
 }
 
 bool Application::Init(const std::string& title, s32 width, s32 height)
 {
     // Window
-    m_window.Init(title, width, height);
-    m_window.SetInput(&m_input);
+    bool offline = s_offline.enabled;
+    m_window.Init(title, width, height, !(offline && s_offline.hidden), !offline);
+
+    // Offline input stays neutral: no keys, buttons or mouse movement
+    if (!offline)
+        m_window.SetInput(&m_input);
 
     // GUI
     m_gui.Init(m_window.GetWindow());
 
+    // Hints never change, set once
+    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+    glHint(GL_POLYGON_SMOOTH_HINT, GL_NICEST);
+
+    // Frame uniform block
+    m_frame_buffer = std::make_unique<UniformBuffer<FrameUniforms>>("Frame", FRAME_BINDING);
+    m_frame.resolution = { width, height };
+
     // Time
     m_t1 = std::chrono::system_clock::now();
     m_t2 = std::chrono::system_clock::now();
@@ -28,13 +98,37 @@ bool Application::Init(const std::string& title, s32 width, s32 height)
     // Create User Application Resources
     Create();
 
+    if (offline)
+    {
+        m_gui.show_gui = false;
+        m_delta_time = s_offline.dt;
+        std::printf("INFO: Offline run: %u frames, dt %.6f, seed %llu\n", s_offline.frames, s_offline.dt, (unsigned long long)s_offline.seed);
+
+        if (s_offline.capture)
+        {
+            CaptureSettings capture;
+            capture.format = s_offline.capture_format;
+            capture.fps = static_cast<s32>(std::round(1.0f / s_offline.dt));
+            m_capture.Start(width, height, capture);
+        }
+    }
+
     return true;
 }
 
 bool Application::Start()
 {
+    const bool offline = s_offline.enabled;
+    std::vector<f32> frame_ms;
+    if (offline)
+        frame_ms.reserve(s_offline.frames);
+
+    auto frame_start = std::chrono::steady_clock::now();
     while (!m_window.ShouldClose())
     {
+        if (offline && frame_ms.size() >= s_offline.frames)
+            break;
+
         // Poll events
         m_window.PollEvents();
 
@@ -43,13 +137,23 @@ bool Application::Start()
         std::chrono::duration<f32> elapsed_time = m_t2 - m_t1;
         m_t1 = m_t2;
 
-        // Compute elapsed time
-        m_elapsed_time = elapsed_time.count();
+        // Compute elapsed time, simulated time is fixed offline
+        m_elapsed_time = offline ? s_offline.dt : elapsed_time.count();
         m_last_elapsed_time = m_elapsed_time;
 
-        // Handle User Input
+        // Handle User Input, examples also keep per frame logic here
         ProcessInput();
 
+        if (!offline)
+        {
+            // Toggle frame capture
+            if (m_input.IsKeyPressed(GLFW_KEY_F12))
+            {
+                if (m_capture.IsCapturing()) m_capture.Stop();
+                else                         m_capture.Start(m_window.Width(), m_window.Height());
+            }
+        }
+
         // Update input state
         m_input.Update();
 
@@ -62,21 +166,55 @@ bool Application::Start()
         }
 
 
+        // Hot reload modified shaders
+        m_shaders.Update();
+
+        // Frame uniforms
+        m_frame.time += m_elapsed_time;
+        m_frame.delta_time = m_elapsed_time;
+        m_frame_buffer->Upload(m_frame);
+
         // Rendering pipeline
         PrepareRender();
         // User Rendering
         Render();
 
+        // Sorted submission of queued draws
+        m_queue.Execute();
+
+        // Frame capture, without the GUI
+        if (m_auto_capture)
+            m_capture.Capture();
+
         // GUI
         m_gui.Render();
 
         // Swap frame buffer
         m_window.SwapBuffers();
 
+        // Publish GL state cache counters
+        RenderState::EndFrame();
+
+        if (offline)
+        {
+            auto frame_end = std::chrono::steady_clock::now();
+            frame_ms.push_back(std::chrono::duration<f32, std::milli>(frame_end - frame_start).count());
+            frame_start = frame_end;
+        }
+
         // Update Frame Time
         //UpdateFrameTime();
     }
 
+    // Flush frames still being written
+    m_capture.Stop();
+
+    // Release User Application Resources while the context is still current
+    Destroy();
+
+    if (offline)
+        PrintOfflineSummary(frame_ms);
+
     return true;
 }
 
@@ -100,15 +238,32 @@ void Application::UpdateFrameTime()
     }
 }
 
+void Application::PrintOfflineSummary(std::vector<f32>& frame_ms)
+{
+    if (frame_ms.empty())
+        return;
+
+    f64 total = 0.0;
+    for (f32 ms : frame_ms)
+        total += ms;
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+    size_t n = frame_ms.size();
+    f32 median = n % 2 ? frame_ms[n / 2] : 0.5f * (frame_ms[n / 2 - 1] + frame_ms[n / 2]);
+    f32 p99 = frame_ms[std::min(n - 1, static_cast<size_t>(std::ceil(0.99 * n)) - 1)];
+
+    std::printf("INFO: Offline summary: %zu frames, min %.3f ms, median %.3f ms, p99 %.3f ms, total %.3f s (%.1f FPS)\n",
+        n, frame_ms.front(), median, p99, total / 1000.0, 1000.0 * n / total);
+}
+
 void Application::PrepareRender()
 {
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_MULTISAMPLE);
-    glEnable(GL_LINE_SMOOTH);
-    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-    glHint(GL_POLYGON_SMOOTH_HINT, GL_NICEST);
+    // Redundant state is elided by the cache
+    RenderState::Enable(GL_DEPTH_TEST);
+    RenderState::Enable(GL_BLEND);
+    RenderState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    RenderState::Enable(GL_MULTISAMPLE);
+    RenderState::Enable(GL_LINE_SMOOTH);
 }
 
 // User Defined Functions
@@ -37,6 +37,23 @@
             if (demo.Init("Minimal", 800, 600))
                 demo.Start();
         }
+
+    Offline Mode:
+        Deterministic batch renders and benchmarks. Simulate() gets a fixed
+        dt, ProcessInput() still runs but sees no keys, buttons or mouse
+        movement, vsync is off, the window can be hidden and every Random
+        created without a seed is seeded from the run seed.
+        The run stops after a frame count and prints min, median, p99 and
+        total frame time.
+
+        Any example can run offline through the environment:
+            GLT_OFFLINE="frames=600 dt=0.0166667 seed=42 hidden=1 capture=png" ./fractal
+
+        or in code, before the Application is constructed so member Random
+        instances are seeded:
+            OfflineSettings offline;
+            offline.enabled = true;
+            Application::SetOffline(offline);
 */
 #pragma once
 
@@ -46,18 +63,40 @@
 #include <memory>
 #include <chrono>
 #include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
 
 #include "Core/Common.h"
 #include "Core/Random.h"
 #include "Core/Window.h"
 #include "Core/Input.h"
 #include "GUI/GUI.h"
+#include "Graphics/ShaderLibrary.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/FrameCapture.h"
+
+struct OfflineSettings
+{
+    bool enabled = false;
+    u32 frames = 600;
+    f32 dt = 1.0f / 60.0f;
+    u64 seed = 1;
+    bool hidden = true;
+    bool capture = false;
+    CaptureFormat capture_format = CAPTURE_PNG;
+};
 
 class Application
 {
 public:
     Application();
 
+    // Call before constructing the Application, see Offline Mode
+    static void SetOffline(const OfflineSettings& settings);
+    static bool ParseOffline(const std::string& spec, OfflineSettings& settings);
+
 public: // Interface
     bool Init(const std::string& title = "GL Template", s32 width = 800, s32 height = 600);
     bool Start();
@@ -68,18 +107,39 @@ protected: // Main functions to override
     virtual void ProcessInput();
     virtual void Simulate(f32 dt);
     virtual void Render();
+
+    // Runs once after the main loop, the GL context is still current
     virtual void Destroy();
 
 protected:
     Window m_window;
     Input m_input;
     GUI m_gui;
+    ShaderLibrary m_shaders;
+
+    // Per-frame uniform block, uploaded before Render()
+    FrameUniforms m_frame;
+
+    // Packets submitted during Render() are sorted and drawn after it returns
+    RenderQueue m_queue;
+
+    // Reads back the default framebuffer after the queue, before the GUI.
+    // F12 toggles a PNG sequence, Start() it directly for video or a
+    // PostProcessor target and call Capture() yourself
+    FrameCapture m_capture;
+    bool m_auto_capture = true;
+
+    // Offline runs, valid for the whole lifetime of the Application
+    static inline OfflineSettings s_offline;
 
 private:
     void UpdateFrameTime();
     void PrepareRender();
+    void PrintOfflineSummary(std::vector<f32>& frame_ms);
 
 private:
+    std::unique_ptr<UniformBuffer<FrameUniforms>> m_frame_buffer;
+
     // Timing
     std::chrono::time_point<std::chrono::system_clock> m_t1;
     std::chrono::time_point<std::chrono::system_clock> m_t2;
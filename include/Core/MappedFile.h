@@ -0,0 +1,40 @@
+/*
+	Mapped File
+		Read-only memory mapping of a whole file. The contents are paged in
+		by the OS on first access and shared between processes, so large
+		precomputed data can be used in place without a load step.
+*/
+#pragma once
+
+#include <string>
+
+#include "Common.h"
+
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	const u8* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+private:
+	const u8* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
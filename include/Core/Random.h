@@ -1,86 +1,753 @@
+/*
+	Random
+		Random number generation on top of a selectable engine. All engines
+		satisfy UniformRandomBitGenerator and also work with <random>.
+			Xoshiro256pp  default, 256-bit state, jump() for parallel streams
+			Pcg64         128-bit LCG with XSL-RR output, streams by increment
+			SplitMix64    64-bit state, used for seeding the others
+		BasicRandom<std::mt19937> keeps the old engine when sequences from
+		earlier builds must be reproduced, see Distributions.
+
+	Distributions
+		Scalar draws map engine bits directly instead of constructing a
+		<random> distribution per call: floats take the top 24 bits, integers
+		use Lemire's multiply and reject, normals the polar method.
+		RandomMT is the exception, its scalar and vector draws go through
+		the std::uniform_*, normal and bernoulli distributions one value at
+		a time like earlier builds did. Its fill_* spans are new and use the
+		bulk path.
+
+	Bulk
+		fill_* write into caller owned spans. They draw from a separate four
+		lane xoshiro256++ (SSE2 where available) seeded from the engine, so
+		bulk and scalar draws are independent streams that are each
+		reproducible from the seed.
+
+	Streams
+		fork(n) returns a generator for stream n that does not overlap the
+		parent, e.g. one per worker thread. Xoshiro jumps 2^128 steps per
+		stream, PCG selects its increment, other engines are reseeded from a
+		hash of the seed and stream.
+
+	Counter Based
+		CounterRandom has no mutable state. Every draw is Philox4x32-10 of
+		(index, stream) under the seed, so element i gets the same values on
+		any thread and in any order. One index yields four 32-bit lanes, e.g.
+		rgb for a pixel or a normal pair for a particle position. Use the
+		frame or generation as the stream and the cell or particle as the
+		index. fill_bytes() uses all 16 bytes of every index for bulk noise.
+*/
 #pragma once
 
 #include <random>
 #include <chrono>
 #include <optional>
+#include <atomic>
+#include <span>
+#include <array>
+#include <vector>
+#include <limits>
+#include <cstring>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+	#include <emmintrin.h>
+	#define GLT_RANDOM_SSE2 1
+#endif
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
 
 #include "Common.h"
 
-class Random
+inline u64 rotl64(u64 x, s32 k) { return (x << k) | (x >> (64 - k)); }
+inline u64 rotr64(u64 x, s32 k) { return (x >> k) | (x << ((64 - k) & 63)); }
+// Top 24 bits to [0, 1)
+inline f32 unit_f32(u32 bits) { return static_cast<f32>(bits >> 8) * (1.0f / 16777216.0f); }
+
+// Engines
+class SplitMix64
+{
+public:
+	using result_type = u64;
+	static constexpr u64 min() { return 0; }
+	static constexpr u64 max() { return std::numeric_limits<u64>::max(); }
+
+	SplitMix64(u64 seed = 0) : m_state(seed) {}
+
+	void seed(u64 seed) { m_state = seed; }
+
+	u64 operator()()
+	{
+		u64 z = (m_state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+private:
+	u64 m_state;
+};
+
+class Xoshiro256pp
+{
+public:
+	using result_type = u64;
+	static constexpr u64 min() { return 0; }
+	static constexpr u64 max() { return std::numeric_limits<u64>::max(); }
+
+	Xoshiro256pp(u64 seed = 0) { this->seed(seed); }
+
+	void seed(u64 seed)
+	{
+		SplitMix64 sm(seed);
+		for (u64& word : m_s)
+			word = sm();
+	}
+
+	u64 operator()()
+	{
+		u64 result = rotl64(m_s[0] + m_s[3], 23) + m_s[0];
+		u64 t = m_s[1] << 17;
+		m_s[2] ^= m_s[0];
+		m_s[3] ^= m_s[1];
+		m_s[1] ^= m_s[2];
+		m_s[0] ^= m_s[3];
+		m_s[2] ^= t;
+		m_s[3] = rotl64(m_s[3], 45);
+		return result;
+	}
+
+	// Advance by 2^128 draws, 2^128 non-overlapping streams
+	void jump()      { Jump({ 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull }); }
+	// Advance by 2^192 draws, e.g. one long jump per machine, jump() per thread
+	void long_jump() { Jump({ 0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull, 0x77710069854EE241ull, 0x39109BB02ACBE635ull }); }
+
+	const u64* state() const { return m_s; }
+
+private:
+	void Jump(std::array<u64, 4> polynomial)
+	{
+		u64 s[4] = {};
+		for (u64 word : polynomial)
+		{
+			for (s32 b = 0; b < 64; b++)
+			{
+				if (word & (1ull << b))
+					for (s32 i = 0; i < 4; i++)
+						s[i] ^= m_s[i];
+				(*this)();
+			}
+		}
+		std::memcpy(m_s, s, sizeof(m_s));
+	}
+
+private:
+	u64 m_s[4];
+};
+
+class Pcg64
 {
 public:
-	Random(size_t seed = std::random_device{}()) : mt(seed) {}
+	using result_type = u64;
+	static constexpr u64 min() { return 0; }
+	static constexpr u64 max() { return std::numeric_limits<u64>::max(); }
 
+	Pcg64(u64 seed = 0, u64 stream = 0) { this->seed(seed, stream); }
+
+	void seed(u64 seed, u64 stream = 0)
+	{
+		SplitMix64 sm(seed);
+		SplitMix64 sm_stream(stream ^ 0xDA3E39CB94B95BDBull);
+		m_inc_hi = sm_stream();
+		m_inc_lo = sm_stream() | 1;
+		m_hi = 0;
+		m_lo = 0;
+		Step();
+		u64 lo = m_lo;
+		m_lo += sm();
+		m_hi += sm() + (m_lo < lo);
+		Step();
+	}
+
+	u64 operator()()
+	{
+		Step();
+		return rotr64(m_hi ^ m_lo, static_cast<s32>(m_hi >> 58));
+	}
+
+private:
+	// state = state * MUL + inc, modulo 2^128
+	void Step()
+	{
+		constexpr u64 MUL_HI = 2549297995355413924ull;
+		constexpr u64 MUL_LO = 4865540595714422341ull;
+
+		u64 lo, hi;
+#if defined(__SIZEOF_INT128__)
+		unsigned __int128 p = static_cast<unsigned __int128>(m_lo) * MUL_LO;
+		lo = static_cast<u64>(p);
+		hi = static_cast<u64>(p >> 64);
+#elif defined(_MSC_VER)
+		lo = m_lo * MUL_LO;
+		hi = __umulh(m_lo, MUL_LO);
+#endif
+		hi += m_lo * MUL_HI + m_hi * MUL_LO;
+
+		m_lo = lo + m_inc_lo;
+		m_hi = hi + m_inc_hi + (m_lo < lo);
+	}
+
+private:
+	u64 m_hi, m_lo;
+	u64 m_inc_hi, m_inc_lo;
+};
+
+// Four interleaved xoshiro256++ lanes for bulk generation
+class Xoshiro256ppX4
+{
 public:
+	void seed(u64 seed)
+	{
+		// Lane i starts i jumps ahead of lane 0
+		Xoshiro256pp lane(seed);
+		for (s32 i = 0; i < 4; i++)
+		{
+			for (s32 w = 0; w < 4; w++)
+				m_s[w][i] = lane.state()[w];
+			lane.jump();
+		}
+	}
+
+	// Writes 4 values
+	void next(u64* out)
+	{
+#ifdef GLT_RANDOM_SSE2
+		auto rotl = [](__m128i x, s32 k) { return _mm_or_si128(_mm_slli_epi64(x, k), _mm_srli_epi64(x, 64 - k)); };
+		for (s32 h = 0; h < 4; h += 2)
+		{
+			__m128i s0 = _mm_load_si128(reinterpret_cast<const __m128i*>(&m_s[0][h]));
+			__m128i s1 = _mm_load_si128(reinterpret_cast<const __m128i*>(&m_s[1][h]));
+			__m128i s2 = _mm_load_si128(reinterpret_cast<const __m128i*>(&m_s[2][h]));
+			__m128i s3 = _mm_load_si128(reinterpret_cast<const __m128i*>(&m_s[3][h]));
+
+			__m128i result = _mm_add_epi64(rotl(_mm_add_epi64(s0, s3), 23), s0);
+			__m128i t = _mm_slli_epi64(s1, 17);
+			s2 = _mm_xor_si128(s2, s0);
+			s3 = _mm_xor_si128(s3, s1);
+			s1 = _mm_xor_si128(s1, s2);
+			s0 = _mm_xor_si128(s0, s3);
+			s2 = _mm_xor_si128(s2, t);
+			s3 = rotl(s3, 45);
+
+			_mm_store_si128(reinterpret_cast<__m128i*>(&m_s[0][h]), s0);
+			_mm_store_si128(reinterpret_cast<__m128i*>(&m_s[1][h]), s1);
+			_mm_store_si128(reinterpret_cast<__m128i*>(&m_s[2][h]), s2);
+			_mm_store_si128(reinterpret_cast<__m128i*>(&m_s[3][h]), s3);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + h), result);
+		}
+#else
+		for (s32 i = 0; i < 4; i++)
+		{
+			out[i] = rotl64(m_s[0][i] + m_s[3][i], 23) + m_s[0][i];
+			u64 t = m_s[1][i] << 17;
+			m_s[2][i] ^= m_s[0][i];
+			m_s[3][i] ^= m_s[1][i];
+			m_s[1][i] ^= m_s[2][i];
+			m_s[0][i] ^= m_s[3][i];
+			m_s[2][i] ^= t;
+			m_s[3][i] = rotl64(m_s[3][i], 45);
+		}
+#endif
+	}
+
+	// count is rounded up to a multiple of 4, out must have room
+	void fill(u64* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i += 4)
+			next(out + i);
+	}
+
+private:
+	alignas(16) u64 m_s[4][4] = {}; // [word][lane]
+};
+
+// Seeding shared by every generator
+struct RandomSeeding
+{
+	// Deterministic runs: every Random constructed or reseeded without an
+	// explicit seed afterwards gets default_seed + its creation order
+	static void SetDefaultSeed(std::optional<u64> seed)
+	{
+		s_default_seed = seed;
+		s_instances = 0;
+	}
+
+	static u64 NextSeed()
+	{
+		if (s_default_seed.has_value())
+			return s_default_seed.value() + s_instances++;
+		return std::random_device{}();
+	}
+
+	static inline std::optional<u64> s_default_seed;
+	static inline std::atomic<u64> s_instances = 0;
+};
+
+template <typename Engine>
+class BasicRandom
+{
+public:
+	BasicRandom() : BasicRandom(RandomSeeding::NextSeed()) {}
+	BasicRandom(size_t seed) : m_seed(seed), m_engine(static_cast<typename Engine::result_type>(seed)) {}
+
+public:
+	static void SetDefaultSeed(std::optional<u64> seed) { RandomSeeding::SetDefaultSeed(seed); }
+
 	void seed(std::optional<size_t> seed = std::nullopt)
 	{
 		if (seed.has_value())
 		{
-			mt.seed(seed.value());
+			m_seed = seed.value();
+		}
+		else if (RandomSeeding::s_default_seed.has_value())
+		{
+			m_seed = RandomSeeding::NextSeed();
 		}
 		else
 		{
 			auto now = std::chrono::high_resolution_clock::now();
-			mt.seed(std::random_device{}() ^ now.time_since_epoch().count());
+			m_seed = std::random_device{}() ^ now.time_since_epoch().count();
+		}
+
+		m_engine.seed(static_cast<typename Engine::result_type>(m_seed));
+		m_bulk_seeded = false;
+		m_has_spare = false;
+	}
+
+	// Independent generator for stream n, e.g. one per worker thread
+	BasicRandom fork(u64 stream) const
+	{
+		BasicRandom r(*this);
+		if constexpr (requires(Engine e) { e.jump(); })
+		{
+			for (u64 i = 0; i <= stream; i++)
+				r.m_engine.jump();
+		}
+		else if constexpr (std::is_same_v<Engine, Pcg64>)
+		{
+			r.m_engine.seed(m_seed, stream + 1);
 		}
+		else
+		{
+			SplitMix64 sm(m_seed ^ (0x9E3779B97F4A7C15ull * (stream + 1)));
+			r.m_engine.seed(static_cast<typename Engine::result_type>(sm()));
+		}
+		r.m_bulk_seeded = false;
+		r.m_has_spare = false;
+		return r;
 	}
 
+	Engine& engine() { return m_engine; }
+
+	// Scalar
+	inline u64 next()
+	{
+		if constexpr (Engine::max() - Engine::min() >= std::numeric_limits<u64>::max())
+			return m_engine();
+		else
+			return (static_cast<u64>(m_engine() - Engine::min()) << 32) ^ static_cast<u64>(m_engine() - Engine::min());
+	}
+
+	// [min, max)
 	inline f32 uniform(f32 min, f32 max)
 	{
-		std::uniform_real_distribution<f32>dist(min, max);
-		return dist(mt);
+		if constexpr (STD_DISTRIBUTIONS)
+			return std::uniform_real_distribution<f32>(min, max)(m_engine);
+
+		return min + (max - min) * unit_f32(static_cast<u32>(next() >> 32));
 	}
 
+	// [min, max]
 	inline s32 uniformi(s32 min, s32 max)
 	{
-		std::uniform_int_distribution<s32>dist(min, max);
-		return dist(mt);
+		if constexpr (STD_DISTRIBUTIONS)
+			return std::uniform_int_distribution<s32>(min, max)(m_engine);
+
+		u64 range = static_cast<u64>(static_cast<s64>(max) - min) + 1;
+		return static_cast<s32>(min + static_cast<s64>(Bounded(range)));
 	}
 
 	inline f32 normal(f32 mu, f32 sigma)
 	{
-		std::normal_distribution<f32>dist(mu, sigma);
-		return dist(mt);
-	};
+		// A fresh distribution per call drops its cached second value
+		if constexpr (STD_DISTRIBUTIONS)
+			return std::normal_distribution<f32>(mu, sigma)(m_engine);
+
+		if (m_has_spare)
+		{
+			m_has_spare = false;
+			return mu + sigma * m_spare;
+		}
+
+		// Marsaglia polar method, yields two values
+		f32 u, v, s;
+		do
+		{
+			u = uniform(-1.0f, 1.0f);
+			v = uniform(-1.0f, 1.0f);
+			s = u * u + v * v;
+		} while (s >= 1.0f || s == 0.0f);
+
+		f32 scale = std::sqrt(-2.0f * std::log(s) / s);
+		m_spare = v * scale;
+		m_has_spare = true;
+		return mu + sigma * u * scale;
+	}
 
 	inline bool bernoulli(f32 p)
 	{
-		std::bernoulli_distribution dist(p);
-		return dist(mt);
+		if constexpr (STD_DISTRIBUTIONS)
+			return std::bernoulli_distribution(p)(m_engine);
+
+		return unit_f32(static_cast<u32>(next() >> 32)) < p;
+	}
+
+	// Bulk
+	void fill_bits(std::span<u64> out)
+	{
+		SeedBulk();
+		size_t whole = out.size() & ~size_t(3);
+		m_bulk.fill(out.data(), whole);
+		if (whole < out.size())
+		{
+			u64 tail[4];
+			m_bulk.next(tail);
+			std::memcpy(out.data() + whole, tail, (out.size() - whole) * sizeof(u64));
+		}
+	}
+
+	void fill_bytes(std::span<u8> out)
+	{
+		ForEachChunk(out.size() / 8 + 1, [&](const u64* bits, size_t offset, size_t count) {
+			size_t begin = offset * 8;
+			size_t bytes = std::min(count * 8, out.size() - begin);
+			std::memcpy(out.data() + begin, bits, bytes);
+		});
+	}
+
+	// [min, max)
+	void fill_uniform(std::span<f32> out, f32 min, f32 max)
+	{
+		f32 range = max - min;
+		ForEachChunk((out.size() + 1) / 2, [&](const u64* bits, size_t offset, size_t count) {
+			const u32* halves = reinterpret_cast<const u32*>(bits);
+			size_t begin = offset * 2;
+			size_t n = std::min(count * 2, out.size() - begin);
+			f32* dst = out.data() + begin;
+			for (size_t i = 0; i < n; i++)
+				dst[i] = min + range * unit_f32(halves[i]);
+		});
+	}
+
+	// [min, max]
+	void fill_uniformi(std::span<s32> out, s32 min, s32 max)
+	{
+		u64 range = static_cast<u64>(static_cast<s64>(max) - min) + 1;
+		if (range > std::numeric_limits<u32>::max())
+		{
+			for (s32& v : out)
+				v = uniformi(min, max);
+			return;
+		}
+
+		u32 range32 = static_cast<u32>(range);
+		u32 threshold = (0u - range32) % range32;
+		ForEachChunk((out.size() + 1) / 2, [&](const u64* bits, size_t offset, size_t count) {
+			const u32* halves = reinterpret_cast<const u32*>(bits);
+			size_t begin = offset * 2;
+			size_t n = std::min(count * 2, out.size() - begin);
+			s32* dst = out.data() + begin;
+			for (size_t i = 0; i < n; i++)
+			{
+				u64 m = static_cast<u64>(halves[i]) * range32;
+				// Biased draws are rare, redo them on the scalar path
+				if (static_cast<u32>(m) < threshold)
+					m = static_cast<u64>(Bounded(range32)) << 32;
+				dst[i] = static_cast<s32>(min + static_cast<s64>(m >> 32));
+			}
+		});
+	}
+
+	void fill_normal(std::span<f32> out, f32 mu, f32 sigma)
+	{
+		// Box-Muller, two outputs per pair of uniforms
+		constexpr f32 TWO_PI = 6.28318530718f;
+		ForEachChunk((out.size() + 1) / 2, [&](const u64* bits, size_t offset, size_t count) {
+			const u32* halves = reinterpret_cast<const u32*>(bits);
+			size_t begin = offset * 2;
+			size_t n = std::min(count * 2, out.size() - begin);
+			f32* dst = out.data() + begin;
+			for (size_t i = 0; i < n; i += 2)
+			{
+				f32 u1 = 1.0f - unit_f32(halves[i]); // (0, 1]
+				f32 u2 = unit_f32(halves[i + 1]);
+				f32 r = sigma * std::sqrt(-2.0f * std::log(u1));
+				dst[i] = mu + r * std::cos(TWO_PI * u2);
+				if (i + 1 < n)
+					dst[i + 1] = mu + r * std::sin(TWO_PI * u2);
+			}
+		});
+	}
+
+	// 1 with probability p, 0 otherwise
+	void fill_bernoulli(std::span<u8> out, f32 p)
+	{
+		if (p >= 1.0f) { std::memset(out.data(), 1, out.size()); return; }
+		if (p <= 0.0f) { std::memset(out.data(), 0, out.size()); return; }
+
+		u32 threshold = static_cast<u32>(static_cast<f64>(p) * 4294967296.0);
+		ForEachChunk((out.size() + 1) / 2, [&](const u64* bits, size_t offset, size_t count) {
+			const u32* halves = reinterpret_cast<const u32*>(bits);
+			size_t begin = offset * 2;
+			size_t n = std::min(count * 2, out.size() - begin);
+			u8* dst = out.data() + begin;
+			for (size_t i = 0; i < n; i++)
+				dst[i] = halves[i] < threshold;
+		});
 	}
 
 	inline std::vector<f32> uniform(f32 min, f32 max, u32 size)
 	{
 		std::vector<f32> res(size);
-		for (u32 i = 0; i < res.size(); i++)
-			res[i] = uniform(min, max);
+		if constexpr (STD_DISTRIBUTIONS)
+			for (f32& v : res) v = uniform(min, max);
+		else
+			fill_uniform(res, min, max);
 		return res;
 	}
 
 	inline std::vector<s32> uniformi(s32 min, s32 max, u32 size)
 	{
 		std::vector<s32> res(size);
-		for (u32 i = 0; i < res.size(); i++)
-			res[i] = uniformi(min, max);
+		if constexpr (STD_DISTRIBUTIONS)
+			for (s32& v : res) v = uniformi(min, max);
+		else
+			fill_uniformi(res, min, max);
 		return res;
 	}
 
 	inline std::vector<f32> normal(f32 mu, f32 sigma, u32 size)
 	{
 		std::vector<f32> res(size);
-		for (u32 i = 0; i < res.size(); i++)
-			res[i] = normal(mu, sigma);
+		if constexpr (STD_DISTRIBUTIONS)
+			for (f32& v : res) v = normal(mu, sigma);
+		else
+			fill_normal(res, mu, sigma);
 		return res;
 	}
 
-	inline std::vector<f32> bernoulli(f32 p, u32 size)
+	inline std::vector<u8> bernoulli(f32 p, u32 size)
 	{
-		std::vector<f32> res(size);
-		for (u32 i = 0; i < res.size(); i++)
-			res[i] = bernoulli(p);
+		std::vector<u8> res(size);
+		if constexpr (STD_DISTRIBUTIONS)
+			for (u8& v : res) v = bernoulli(p);
+		else
+			fill_bernoulli(res, p);
 		return res;
 	}
 
 private:
-	std::mt19937 mt;
-};
\ No newline at end of file
+	// Sequences of earlier builds, see Distributions
+	static constexpr bool STD_DISTRIBUTIONS = std::is_same_v<Engine, std::mt19937>;
+
+	// Lemire's nearly divisionless bounded draw, [0, range)
+	u64 Bounded(u64 range)
+	{
+		if (range > std::numeric_limits<u32>::max())
+			return range == (1ull << 32) ? next() >> 32 : next() % range;
+
+		u32 range32 = static_cast<u32>(range);
+		u64 m = (next() >> 32) * range32;
+		if (static_cast<u32>(m) < range32)
+		{
+			u32 threshold = (0u - range32) % range32;
+			while (static_cast<u32>(m) < threshold)
+				m = (next() >> 32) * range32;
+		}
+		return m >> 32;
+	}
+
+	void SeedBulk()
+	{
+		if (m_bulk_seeded)
+			return;
+		m_bulk.seed(next());
+		m_bulk_seeded = true;
+	}
+
+	// Generates count u64 in stack sized chunks, fn(bits, offset, count)
+	template <typename F>
+	void ForEachChunk(size_t count, F&& fn)
+	{
+		constexpr size_t CHUNK = 256;
+		alignas(16) u64 bits[CHUNK];
+
+		SeedBulk();
+		for (size_t offset = 0; offset < count; offset += CHUNK)
+		{
+			size_t n = std::min(CHUNK, count - offset);
+			m_bulk.fill(bits, n);
+			fn(bits, offset, n);
+		}
+	}
+
+private:
+	u64 m_seed = 0;
+	Engine m_engine;
+
+	Xoshiro256ppX4 m_bulk;
+	bool m_bulk_seeded = false;
+
+	f32 m_spare = 0.0f;
+	bool m_has_spare = false;
+};
+
+using Random = BasicRandom<Xoshiro256pp>;
+using RandomPCG = BasicRandom<Pcg64>;
+using RandomMT = BasicRandom<std::mt19937>;
+
+// Philox4x32-10 (Salmon et al. 2011), counter based, 4 outputs per block
+struct Philox4x32
+{
+	static std::array<u32, 4> Generate(std::array<u32, 4> ctr, std::array<u32, 2> key)
+	{
+		constexpr u32 M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+		constexpr u32 W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+		for (s32 round = 0; round < 10; round++)
+		{
+			u64 p0 = static_cast<u64>(M0) * ctr[0];
+			u64 p1 = static_cast<u64>(M1) * ctr[2];
+			ctr = {
+				static_cast<u32>(p1 >> 32) ^ ctr[1] ^ key[0],
+				static_cast<u32>(p1),
+				static_cast<u32>(p0 >> 32) ^ ctr[3] ^ key[1],
+				static_cast<u32>(p0)
+			};
+			key[0] += W0;
+			key[1] += W1;
+		}
+		return ctr;
+	}
+};
+
+class CounterRandom
+{
+public:
+	CounterRandom() : CounterRandom(RandomSeeding::NextSeed()) {}
+	CounterRandom(u64 seed, u64 stream = 0) : m_seed(seed), m_stream(stream) {}
+
+public:
+	// Same seed, different stream, e.g. frame number or generation
+	CounterRandom fork(u64 stream) const { return CounterRandom(m_seed, stream); }
+
+	u64 seed() const { return m_seed; }
+	u64 stream() const { return m_stream; }
+
+	std::array<u32, 4> bits(u64 index) const
+	{
+		return Philox4x32::Generate(
+			{ static_cast<u32>(index), static_cast<u32>(index >> 32), static_cast<u32>(m_stream), static_cast<u32>(m_stream >> 32) },
+			{ static_cast<u32>(m_seed), static_cast<u32>(m_seed >> 32) });
+	}
+
+	// [min, max), lane 0..3 selects one of the four values of the index
+	f32 uniform(u64 index, f32 min, f32 max, u32 lane = 0) const
+	{
+		return min + (max - min) * unit_f32(bits(index)[lane & 3]);
+	}
+
+	// [min, max], multiply-shift without rejection, the bias is below range / 2^32
+	s32 uniformi(u64 index, s32 min, s32 max, u32 lane = 0) const
+	{
+		u64 range = static_cast<u64>(static_cast<s64>(max) - min) + 1;
+		return static_cast<s32>(min + static_cast<s64>((bits(index)[lane & 3] * range) >> 32));
+	}
+
+	bool bernoulli(u64 index, f32 p, u32 lane = 0) const
+	{
+		return unit_f32(bits(index)[lane & 3]) < p;
+	}
+
+	// Box-Muller pair from lanes 0 and 1
+	vf2 normal2(u64 index, vf2 mu, vf2 sigma) const
+	{
+		return mu + sigma * BoxMuller(bits(index), 0);
+	}
+
+	// pair 0 uses lanes 0-1, pair 1 lanes 2-3
+	f32 normal(u64 index, f32 mu, f32 sigma, u32 pair = 0) const
+	{
+		return mu + sigma * BoxMuller(bits(index), (pair & 1) * 2).x;
+	}
+
+	// Flat sequence of four values per index: element j is lane j % 4 of
+	// index j / 4, out receives elements first .. first + size - 1
+	void fill_uniform(std::span<f32> out, f32 min, f32 max, u64 first = 0) const
+	{
+		f32 range = max - min;
+		for (size_t i = 0; i < out.size();)
+		{
+			u64 j = first + i;
+			std::array<u32, 4> b = bits(j / 4);
+			for (u32 lane = j % 4; lane < 4 && i < out.size(); lane++, i++)
+				out[i] = min + range * unit_f32(b[lane]);
+		}
+	}
+
+	// Two values per index: element j is pair j % 2 of index j / 2
+	void fill_normal(std::span<f32> out, f32 mu, f32 sigma, u64 first = 0) const
+	{
+		for (size_t i = 0; i < out.size();)
+		{
+			u64 j = first + i;
+			std::array<u32, 4> b = bits(j / 2);
+			for (u32 pair = j % 2; pair < 2 && i < out.size(); pair++, i++)
+				out[i] = mu + sigma * BoxMuller(b, pair * 2).x;
+		}
+	}
+
+	// Sixteen bytes per index: byte j is byte j % 16 of index j / 16,
+	// lanes in order, each little endian
+	void fill_bytes(std::span<u8> out, u64 first = 0) const
+	{
+		for (size_t i = 0; i < out.size();)
+		{
+			u64 j = first + i;
+			std::array<u32, 4> b = bits(j / 16);
+			u8 bytes[16];
+			for (u32 lane = 0; lane < 4; lane++)
+				for (u32 k = 0; k < 4; k++)
+					bytes[lane * 4 + k] = static_cast<u8>(b[lane] >> (8 * k));
+
+			size_t n = std::min<size_t>(16 - j % 16, out.size() - i);
+			std::memcpy(out.data() + i, bytes + j % 16, n);
+			i += n;
+		}
+	}
+
+private:
+	static vf2 BoxMuller(const std::array<u32, 4>& b, u32 lane)
+	{
+		constexpr f32 TWO_PI = 6.28318530718f;
+		f32 u1 = 1.0f - unit_f32(b[lane]); // (0, 1]
+		f32 u2 = unit_f32(b[lane + 1]);
+		f32 r = std::sqrt(-2.0f * std::log(u1));
+		return { r * std::cos(TWO_PI * u2), r * std::sin(TWO_PI * u2) };
+	}
+
+private:
+	u64 m_seed;
+	u64 m_stream;
+};
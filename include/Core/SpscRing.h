@@ -0,0 +1,110 @@
+/*
+	SPSC Ring
+		Lock-free ring buffer for exactly one producer thread and one
+		consumer thread, e.g. the audio callback handing PCM to a worker.
+		Capacity is rounded up to a power of two. Push and Pop never block
+		and never allocate: Push writes what fits and returns the count, the
+		caller decides whether to drop the rest.
+
+		Each side caches the other side's index and only reloads it when the
+		cached value says the ring is full / empty, so the shared indices
+		are touched once per call in the common case.
+*/
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "Common.h"
+
+template <typename T>
+class SpscRing
+{
+	static_assert(std::is_trivially_copyable_v<T>, "SpscRing copies elements with memcpy");
+
+public:
+	SpscRing(size_t capacity = 1 << 16)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		m_data.resize(size);
+		m_mask = size - 1;
+	}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+public:
+	// Producer thread
+	size_t Push(const T* data, size_t count)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (Capacity() - (head - m_tail_cache) < count)
+			m_tail_cache = m_tail.load(std::memory_order_acquire);
+
+		count = std::min(count, Capacity() - (head - m_tail_cache));
+		Write(head, data, count);
+		m_head.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	// Consumer thread
+	size_t Pop(T* out, size_t count)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (m_head_cache - tail < count)
+			m_head_cache = m_head.load(std::memory_order_acquire);
+
+		count = std::min(count, m_head_cache - tail);
+		Read(tail, out, count);
+		m_tail.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	// Approximate from either side
+	size_t Size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+	size_t Capacity() const { return m_mask + 1; }
+
+	// Only while neither side is running
+	void Clear()
+	{
+		m_head = 0;
+		m_tail = 0;
+		m_head_cache = 0;
+		m_tail_cache = 0;
+	}
+
+private:
+	// Ring wraps at most once per copy
+	void Write(size_t index, const T* src, size_t count)
+	{
+		size_t start = index & m_mask;
+		size_t first = std::min(count, Capacity() - start);
+		std::memcpy(m_data.data() + start, src, first * sizeof(T));
+		std::memcpy(m_data.data(), src + first, (count - first) * sizeof(T));
+	}
+
+	void Read(size_t index, T* dst, size_t count) const
+	{
+		size_t start = index & m_mask;
+		size_t first = std::min(count, Capacity() - start);
+		std::memcpy(dst, m_data.data() + start, first * sizeof(T));
+		std::memcpy(dst + first, m_data.data(), (count - first) * sizeof(T));
+	}
+
+private:
+	std::vector<T> m_data;
+	size_t m_mask = 0;
+
+	// Written by the producer
+	alignas(64) std::atomic<size_t> m_head = 0;
+	size_t m_tail_cache = 0;
+
+	// Written by the consumer
+	alignas(64) std::atomic<size_t> m_tail = 0;
+	size_t m_head_cache = 0;
+};
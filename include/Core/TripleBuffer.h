@@ -0,0 +1,56 @@
+/*
+	Triple Buffer
+		Latest value handoff from one writer thread to one reader thread
+		without locks or waiting. The writer fills the back slot and
+		publishes it by swapping it with the middle slot, the reader swaps
+		the middle slot into the front when something new was published.
+		The reader always sees the most recent complete value, older ones
+		are overwritten, never queued.
+*/
+#pragma once
+
+#include <atomic>
+
+#include "Common.h"
+
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() {}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+public:
+	// Writer thread: fill Back(), then Publish()
+	T& Back() { return m_slots[m_back]; }
+
+	void Publish()
+	{
+		u8 previous = m_middle.exchange(static_cast<u8>(m_back | DIRTY), std::memory_order_acq_rel);
+		m_back = previous & INDEX;
+	}
+
+	// Reader thread: returns the latest published value, true if it is new
+	bool Update()
+	{
+		if (!(m_middle.load(std::memory_order_relaxed) & DIRTY))
+			return false;
+
+		u8 previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+		m_front = previous & INDEX;
+		return true;
+	}
+
+	const T& Front() const { return m_slots[m_front]; }
+
+private:
+	static constexpr u8 INDEX = 0x3;
+	static constexpr u8 DIRTY = 0x4;
+
+	T m_slots[3] = {};
+	u8 m_front = 0;
+	u8 m_back = 1;
+	std::atomic<u8> m_middle = 2;
+};
@@ -2,7 +2,7 @@
 
 Window::Window() {}
 
-void Window::Init(const std::string& title, s32 width, s32 height)
+void Window::Init(const std::string& title, s32 width, s32 height, bool visible, bool vsync)
 {
     m_title = title;
     m_width = width;
@@ -21,6 +21,7 @@ void Window::Init(const std::string& title, s32 width, s32 height)
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
     glfwWindowHint(GLFW_FOCUSED, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GL_TRUE : GL_FALSE);
     std::printf("INFO: GLFW %d.%d.%d\n", GLFW_VERSION_MAJOR, GLFW_VERSION_MINOR, GLFW_VERSION_REVISION);
 
     m_window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
@@ -33,7 +34,7 @@ void Window::Init(const std::string& title, s32 width, s32 height)
     glfwSetWindowUserPointer(m_window, this);
 
     glfwMakeContextCurrent(m_window);
-    glfwSwapInterval(1); // Enable vsync
+    glfwSwapInterval(vsync ? 1 : 0);
 
     glfwSetFramebufferSizeCallback(m_window, framebuffer_size_callback);
     glfwSetKeyCallback(m_window, key_callback);
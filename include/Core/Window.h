@@ -15,7 +15,7 @@ public:
     Window();
 
 public:
-    void Init(const std::string& title = "GL Template", s32 width = 800, s32 height = 600);
+    void Init(const std::string& title = "GL Template", s32 width = 800, s32 height = 600, bool visible = true, bool vsync = true);
     void SetInput(Input* input);
 
     void PollEvents();
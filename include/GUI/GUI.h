@@ -3,6 +3,7 @@
 #include <functional>
 
 #include "Core/Common.h"
+#include "Graphics/RenderState.h"
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -33,6 +34,8 @@ public:
     {
         ImGui::Begin("FPS");
         ImGui::Text("FPS: average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+        const RenderState::Stats& gl = RenderState::LastFrame();
+        ImGui::Text("GL state calls: %llu issued, %llu elided", (unsigned long long)gl.issued, (unsigned long long)gl.elided);
         ImGui::Checkbox("Show ImGui Demo", &show_imgui_demo);
         if (show_imgui_demo)  ImGui::ShowDemoWindow();
         ImGui::End();
@@ -0,0 +1,373 @@
+#include "FrameCapture.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+// Windows pipes translate newlines unless opened binary, glibc rejects "wb"
+#ifdef _WIN32
+#define popen  _popen
+#define pclose _pclose
+#define PIPE_WRITE "wb"
+#else
+#define PIPE_WRITE "w"
+#endif
+
+FrameCapture::~FrameCapture()
+{
+    Stop();
+}
+
+bool FrameCapture::Start(s32 width, s32 height, const CaptureSettings& settings)
+{
+    if (m_capturing)
+        Stop();
+
+    m_settings = settings;
+    m_width = width;
+    m_height = height;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_settings.directory, error);
+    if (error)
+    {
+        std::printf("ERROR: Could not create capture directory %s\n", m_settings.directory.c_str());
+        return false;
+    }
+
+    if (m_settings.format == CAPTURE_VIDEO)
+    {
+        std::string command = m_settings.encoder;
+        auto replace = [&](const std::string& key, const std::string& value) {
+            for (size_t at = command.find(key); at != std::string::npos; at = command.find(key, at + value.size()))
+                command.replace(at, key.size(), value);
+        };
+        replace("%W", std::to_string(m_width));
+        replace("%H", std::to_string(m_height));
+        replace("%R", std::to_string(m_settings.fps));
+        replace("%O", (std::filesystem::path(m_settings.directory) / m_settings.video_name).string());
+
+        m_pipe = popen(command.c_str(), PIPE_WRITE);
+        if (!m_pipe)
+        {
+            std::printf("ERROR: Could not start encoder: %s\n", command.c_str());
+            return false;
+        }
+    }
+
+    // Pixel pack buffer ring
+    size_t size = static_cast<size_t>(m_width) * m_height * 4;
+    glGenBuffers(RING, m_pbos.data());
+    for (u32 pbo : m_pbos)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_fences.fill(nullptr);
+
+    // Frames must stay in order for the encoder
+    u32 writers = 1;
+    if (m_settings.format == CAPTURE_PNG)
+    {
+        writers = m_settings.png_threads;
+        if (writers == 0)
+            writers = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+
+    m_stopping = false;
+    m_issued = 0;
+    m_collected = 0;
+    m_written = 0;
+    m_stalls = 0;
+    for (u32 i = 0; i < writers; i++)
+        m_writers.emplace_back(&FrameCapture::WriterLoop, this);
+
+    m_capturing = true;
+    std::printf("INFO: Capture started %dx%d into %s (%u writers)\n", m_width, m_height, m_settings.directory.c_str(), writers);
+    return true;
+}
+
+void FrameCapture::Stop()
+{
+    if (!m_capturing)
+        return;
+
+    // Flush frames still in flight on the GPU
+    while (m_collected < m_issued)
+        Collect(true);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_ready.notify_all();
+    for (std::thread& writer : m_writers)
+        writer.join();
+    m_writers.clear();
+
+    if (m_pipe)
+    {
+        pclose(m_pipe);
+        m_pipe = nullptr;
+    }
+
+    glDeleteBuffers(RING, m_pbos.data());
+    m_pbos.fill(0);
+    m_free.clear();
+    m_capturing = false;
+
+    std::printf("INFO: Capture stopped, %u frames written (%u stalls)\n", m_written.load(), m_stalls);
+}
+
+bool FrameCapture::IsCapturing() const
+{
+    return m_capturing;
+}
+
+u32 FrameCapture::FramesWritten() const
+{
+    return m_written.load();
+}
+
+u32 FrameCapture::Stalls() const
+{
+    return m_stalls;
+}
+
+void FrameCapture::Capture(u32 framebuffer)
+{
+    if (!m_capturing)
+        return;
+
+    // Ring full, the oldest readback has to finish first
+    if (m_issued - m_collected == RING)
+        Collect(true);
+
+    u32 slot = m_issued % RING;
+    RenderState::BindFramebuffer(framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_indices[slot] = m_issued;
+    m_issued++;
+
+    // Pick up older readbacks that already landed
+    Collect(false);
+}
+
+void FrameCapture::Collect(bool wait)
+{
+    size_t size = static_cast<size_t>(m_width) * m_height * 4;
+    while (m_collected < m_issued)
+    {
+        u32 slot = m_collected % RING;
+
+        // Only the oldest frame may be waited on
+        GLenum status = glClientWaitSync(m_fences[slot], wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000ull : 0);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+        {
+            if (!wait)
+                return;
+            std::printf("WARNING: Capture readback of frame %u timed out\n", m_indices[slot]);
+        }
+        wait = false;
+
+        Frame frame;
+        frame.index = m_indices[slot];
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free.empty())
+            {
+                frame.pixels = std::move(m_free.back());
+                m_free.pop_back();
+            }
+        }
+        frame.pixels.resize(size);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+        const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if (data)
+        {
+            std::memcpy(frame.pixels.data(), data, size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        glDeleteSync(m_fences[slot]);
+        m_fences[slot] = nullptr;
+        m_collected++;
+
+        Submit(std::move(frame));
+    }
+}
+
+void FrameCapture::Submit(Frame&& frame)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_queue.size() >= m_settings.max_queued)
+    {
+        m_stalls++;
+        m_consumed.wait(lock, [&] { return m_queue.size() < m_settings.max_queued; });
+    }
+    m_queue.push_back(std::move(frame));
+    lock.unlock();
+    m_ready.notify_one();
+}
+
+void FrameCapture::WriterLoop()
+{
+    while (true)
+    {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready.wait(lock, [&] { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty())
+                return;
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_consumed.notify_one();
+
+        if (m_pipe)
+        {
+            std::fwrite(frame.pixels.data(), 1, frame.pixels.size(), m_pipe);
+        }
+        else
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%06u.png", frame.index);
+            std::string path = (std::filesystem::path(m_settings.directory) / name).string();
+            if (!WritePNG(path, m_width, m_height, frame.pixels.data(), true))
+                std::printf("ERROR: Could not write %s\n", path.c_str());
+        }
+        m_written++;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(std::move(frame.pixels));
+    }
+}
+
+// PNG with stored (uncompressed) deflate blocks, see RFC 1950, 1951 and the PNG spec
+bool FrameCapture::WritePNG(const std::string& path, s32 width, s32 height, const u8* rgba, bool flip)
+{
+    static const std::array<u32, 256> crc_table = [] {
+        std::array<u32, 256> table = {};
+        for (u32 n = 0; n < 256; n++)
+        {
+            u32 c = n;
+            for (s32 k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        return table;
+    }();
+
+    auto crc = [&](u32 c, const u8* data, size_t size) {
+        for (size_t i = 0; i < size; i++)
+            c = crc_table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+        return c;
+    };
+
+    auto put32 = [](std::vector<u8>& out, u32 v) {
+        out.push_back(static_cast<u8>(v >> 24));
+        out.push_back(static_cast<u8>(v >> 16));
+        out.push_back(static_cast<u8>(v >> 8));
+        out.push_back(static_cast<u8>(v));
+    };
+
+    // Scanlines, each prefixed with filter type 0
+    size_t stride = static_cast<size_t>(width) * 4;
+    size_t raw_size = (stride + 1) * height;
+
+    // zlib stream: header, stored blocks of at most 65535 bytes, adler32
+    const size_t BLOCK = 65535;
+    size_t blocks = (raw_size + BLOCK - 1) / BLOCK;
+    std::vector<u8> idat;
+    idat.reserve(4 + 2 + blocks * 5 + raw_size + 4 + 4);
+    idat.insert(idat.end(), { 'I', 'D', 'A', 'T' });
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+
+    u32 s1 = 1, s2 = 0;
+    size_t written = 0;
+    size_t block_left = 0;
+    auto emit = [&](const u8* data, size_t size) {
+        while (size > 0)
+        {
+            if (block_left == 0)
+            {
+                size_t len = std::min(BLOCK, raw_size - written);
+                bool last = written + len == raw_size;
+                idat.push_back(last ? 1 : 0);
+                idat.push_back(static_cast<u8>(len));
+                idat.push_back(static_cast<u8>(len >> 8));
+                idat.push_back(static_cast<u8>(~len));
+                idat.push_back(static_cast<u8>(~len >> 8));
+                block_left = len;
+            }
+
+            size_t n = std::min(size, block_left);
+            idat.insert(idat.end(), data, data + n);
+
+            // Adler-32, 5552 bytes is the most that can be summed before s2 overflows
+            for (size_t i = 0; i < n; )
+            {
+                size_t end = std::min(n, i + 5552);
+                for (; i < end; i++)
+                {
+                    s1 += data[i];
+                    s2 += s1;
+                }
+                s1 %= 65521;
+                s2 %= 65521;
+            }
+
+            data += n;
+            size -= n;
+            block_left -= n;
+            written += n;
+        }
+    };
+
+    const u8 filter = 0;
+    for (s32 y = 0; y < height; y++)
+    {
+        emit(&filter, 1);
+        emit(rgba + stride * (flip ? height - 1 - y : y), stride);
+    }
+    put32(idat, (s2 << 16) | s1);
+
+    std::vector<u8> ihdr = { 'I', 'H', 'D', 'R' };
+    put32(ihdr, width);
+    put32(ihdr, height);
+    ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 }); // 8 bit RGBA
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(signature, 1, sizeof(signature), file);
+
+    auto chunk = [&](const std::vector<u8>& body) {
+        std::vector<u8> header;
+        put32(header, static_cast<u32>(body.size() - 4));
+        std::fwrite(header.data(), 1, header.size(), file);
+        std::fwrite(body.data(), 1, body.size(), file);
+        std::vector<u8> footer;
+        put32(footer, crc(0xFFFFFFFFu, body.data(), body.size()) ^ 0xFFFFFFFFu);
+        std::fwrite(footer.data(), 1, footer.size(), file);
+    };
+    chunk(ihdr);
+    chunk(idat);
+    chunk({ 'I', 'E', 'N', 'D' });
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
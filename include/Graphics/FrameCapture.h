@@ -0,0 +1,121 @@
+/*
+	Frame Capture
+		Saves rendered frames as a PNG sequence or pipes them into an external
+		video encoder.
+
+	Readback
+		Capture() queues an asynchronous glReadPixels into a pixel pack
+		buffer followed by a fence. The buffer is mapped RING - 1 frames
+		later, when the fence has signaled, so the render thread never waits
+		for the transfer. Mapped pixels are copied into a recycled frame and
+		handed to the writer threads.
+
+	Writers
+		PNG: several threads encode frames in parallel, file names carry the
+		frame index so the order does not matter. Frames are stored without
+		compression, encoding is a copy plus a checksum.
+		Video: one thread writes raw RGBA frames in order to the stdin of an
+		encoder process, ffmpeg by default.
+
+	Back Pressure
+		Frames are never dropped. When the writers fall behind by more than
+		max_queued frames, Capture() blocks until one is written, the stall
+		count tells how often that happened.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+#include "Graphics/RenderState.h"
+
+enum CaptureFormat
+{
+	CAPTURE_PNG,
+	CAPTURE_VIDEO
+};
+
+struct CaptureSettings
+{
+	CaptureFormat format = CAPTURE_PNG;
+	std::string directory = "captures";
+	std::string video_name = "capture.mp4";
+	s32 fps = 60;
+	u32 max_queued = 16; // Frames waiting for a writer before Capture() blocks
+	u32 png_threads = 0; // 0 picks from the hardware concurrency
+
+	// %W %H %R and %O are replaced by width, height, frame rate and output path
+	std::string encoder = "ffmpeg -loglevel error -y -f rawvideo -pix_fmt rgba -s %Wx%H -r %R -i - -vf vflip -c:v libx264 -preset fast -pix_fmt yuv420p \"%O\"";
+};
+
+class FrameCapture
+{
+public:
+	FrameCapture() {}
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+public:
+	bool Start(s32 width, s32 height, const CaptureSettings& settings = {});
+	void Stop();
+	bool IsCapturing() const;
+
+	// Call once per frame after rendering, reads the framebuffer's color attachment
+	void Capture(u32 framebuffer = 0);
+
+	u32 FramesWritten() const;
+	u32 Stalls() const;
+
+public:
+	static bool WritePNG(const std::string& path, s32 width, s32 height, const u8* rgba, bool flip);
+
+private:
+	struct Frame
+	{
+		u32 index = 0;
+		std::vector<u8> pixels;
+	};
+
+	void Collect(bool wait);
+	void Submit(Frame&& frame);
+	void WriterLoop();
+
+private:
+	static constexpr u32 RING = 3;
+
+	CaptureSettings m_settings;
+	s32 m_width = 0;
+	s32 m_height = 0;
+	bool m_capturing = false;
+
+	// PBO ring
+	std::array<u32, RING> m_pbos = {};
+	std::array<GLsync, RING> m_fences = {};
+	std::array<u32, RING> m_indices = {};
+	u32 m_issued = 0;
+	u32 m_collected = 0;
+
+	// Writers
+	std::vector<std::thread> m_writers;
+	std::mutex m_mutex;
+	std::condition_variable m_ready;    // Frame queued or stopping
+	std::condition_variable m_consumed; // Frame written
+	std::deque<Frame> m_queue;
+	std::vector<std::vector<u8>> m_free; // Recycled pixel storage
+	bool m_stopping = false;
+	FILE* m_pipe = nullptr;
+
+	std::atomic<u32> m_written = 0;
+	u32 m_stalls = 0;
+};
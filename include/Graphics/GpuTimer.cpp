@@ -0,0 +1,57 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(LATENCY, m_queries.data());
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(LATENCY, m_queries.data());
+}
+
+void GpuTimer::Begin()
+{
+    // Every query still in flight, skip this frame
+    if (m_issued - m_resolved >= LATENCY)
+        return;
+
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_issued % LATENCY]);
+    m_active = true;
+}
+
+void GpuTimer::End()
+{
+    if (!m_active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_active = false;
+    m_issued++;
+}
+
+bool GpuTimer::Poll()
+{
+    bool updated = false;
+    while (m_resolved < m_issued)
+    {
+        u32 query = m_queries[m_resolved % LATENCY];
+
+        s32 available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+        m_ms = static_cast<f32>(ns) / 1.0e6f;
+        m_resolved++;
+        updated = true;
+    }
+    return updated;
+}
+
+f32 GpuTimer::Milliseconds() const
+{
+    return m_ms;
+}
@@ -0,0 +1,44 @@
+/*
+	GPU Timer
+		Measures GPU time between Begin() and End() with GL_TIME_ELAPSED
+		queries. Results arrive a few frames late, queries are kept in a ring
+		and only read once available so the CPU never waits on the GPU.
+		Only one GL_TIME_ELAPSED query may be active at a time, timers must
+		not nest.
+*/
+#pragma once
+
+#include <array>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+
+class GpuTimer
+{
+public:
+	GpuTimer();
+	~GpuTimer();
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+public:
+	void Begin();
+	void End();
+
+	// Reads finished queries, true if a new result arrived
+	bool Poll();
+
+	// Latest result in milliseconds, 0 until the first one arrives
+	f32 Milliseconds() const;
+
+private:
+	static constexpr u32 LATENCY = 4;
+
+	std::array<u32, LATENCY> m_queries = {};
+	u32 m_issued = 0;
+	u32 m_resolved = 0;
+	bool m_active = false;
+	f32 m_ms = 0.0f;
+};
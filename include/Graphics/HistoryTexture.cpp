@@ -0,0 +1,53 @@
+#include "HistoryTexture.h"
+
+#include <vector>
+
+HistoryTexture::HistoryTexture(s32 width, s32 rows) : m_width(width), m_rows(rows)
+{
+    glGenTextures(1, &m_id);
+    RenderState::BindTexture(0, m_id);
+
+    std::vector<f32> zeros(static_cast<size_t>(width) * rows, 0.0f);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, rows, 0, GL_RED, GL_FLOAT, zeros.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+HistoryTexture::~HistoryTexture()
+{
+    RenderState::ForgetTexture(m_id);
+    glDeleteTextures(1, &m_id);
+}
+
+void HistoryTexture::Push(const f32* row)
+{
+    // Rows of floats are always 4 byte aligned, the default unpack alignment holds
+    RenderState::BindTexture(0, m_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_head, m_width, 1, GL_RED, GL_FLOAT, row);
+
+    m_head = (m_head + 1) % m_rows;
+    m_pushed++;
+}
+
+void HistoryTexture::Clear()
+{
+    std::vector<f32> zeros(static_cast<size_t>(m_width) * m_rows, 0.0f);
+    RenderState::BindTexture(0, m_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_rows, GL_RED, GL_FLOAT, zeros.data());
+
+    m_head = 0;
+    m_pushed = 0;
+}
+
+void HistoryTexture::Bind(u32 slot) const
+{
+    RenderState::BindTexture(slot, m_id);
+}
+
+vf2 HistoryTexture::Newest() const
+{
+    s32 newest = (m_head + m_rows - 1) % m_rows;
+    return { (newest + 0.5f) / m_rows, 1.0f / m_rows };
+}
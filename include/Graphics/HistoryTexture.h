@@ -0,0 +1,53 @@
+/*
+	History Texture
+		The last N rows of a per frame signal, e.g. one spectrum per audio
+		hop, kept on the GPU as a ring. Push() uploads a single row with
+		glTexSubImage2D over the oldest one, so the history is never
+		re-uploaded as a whole.
+
+		Rows wrap with GL_REPEAT, a shader walks back in time from the
+		newest row and the ring seam never shows:
+			uniform sampler2D history;
+			uniform vec2 history_newest; // (row + 0.5) / rows, 1 / rows
+			float v = texture(history, vec2(x, history_newest.x - age * history_newest.y)).r;
+		age 0 is the newest row. Columns are clamped and linearly
+		filtered, so x in [0, 1] interpolates across the row.
+*/
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+#include "Graphics/RenderState.h"
+
+class HistoryTexture
+{
+public:
+	HistoryTexture(s32 width, s32 rows);
+	~HistoryTexture();
+
+	HistoryTexture(const HistoryTexture&) = delete;
+	HistoryTexture& operator=(const HistoryTexture&) = delete;
+
+public:
+	// width floats, replaces the oldest row
+	void Push(const f32* row);
+	void Clear();
+
+	void Bind(u32 slot = 0) const;
+
+	// Newest row as the shader's history_newest uniform
+	vf2 Newest() const;
+
+	u32 GetID() const { return m_id; }
+	s32 Width() const { return m_width; }
+	s32 Rows() const { return m_rows; }
+	u64 Pushed() const { return m_pushed; }
+
+private:
+	u32 m_id = 0;
+	s32 m_width = 0;
+	s32 m_rows = 0;
+	s32 m_head = 0; // Next row written
+	u64 m_pushed = 0;
+};
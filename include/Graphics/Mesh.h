@@ -9,6 +9,8 @@
 #include "Core/Common.h"
 #include "Color.h"
 #include "Shader.h"
+#include "RenderState.h"
+#include "RenderQueue.h"
 
 struct vertex
 {
@@ -20,7 +22,7 @@ struct vertex
 
 struct Mesh
 {
-	u32 vao, vbo, ibo;
+	u32 vao = 0, vbo = 0, ibo = 0;
 	std::vector<vertex> vertices;
 	std::vector<u32> indices;
 
@@ -40,6 +42,11 @@ struct Mesh
 
 	~Mesh()
 	{
+		// CPU only mesh, e.g. load_from_file without setup_buffers
+		if (vao == 0)
+			return;
+
+		RenderState::ForgetVertexArray(vao);
 		glDeleteVertexArrays(1, &vao);
 		glDeleteBuffers(1, &vbo);
 		glDeleteBuffers(1, &ibo);
@@ -47,9 +54,25 @@ struct Mesh
 
 	void draw(s32 mode)
 	{
-		glBindVertexArray(vao);
+		RenderState::BindVertexArray(vao);
 		glDrawElements(mode, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+	}
+
+	// Deferred draw, depth in [0, 1] for sorting
+	DrawPacket packet(Shader& shader, s32 mode, RenderPass pass = PASS_OPAQUE, f32 depth = 0.0f)
+	{
+		DrawPacket p;
+		p.program = shader.GetID();
+		p.vao     = vao;
+		p.mode    = mode;
+		p.count   = static_cast<u32>(indices.size());
+		p.key     = RenderQueue::MakeKey(pass, p.program, 0, depth);
+		return p;
+	}
+
+	void submit(RenderQueue& queue, Shader& shader, s32 mode, RenderPass pass = PASS_OPAQUE, f32 depth = 0.0f)
+	{
+		queue.Submit(packet(shader, mode, pass, depth));
 	}
 
 	void setup_buffers()
@@ -59,7 +82,7 @@ struct Mesh
 		glGenBuffers(1, &vbo);
 		glGenBuffers(1, &ibo);
 		// Bind vertex array object
-		glBindVertexArray(vao);
+		RenderState::BindVertexArray(vao);
 
 		// Vertex Buffer Object
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
@@ -87,7 +110,7 @@ struct Mesh
 		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, uv));
 
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		RenderState::BindVertexArray(0);
 	}
 
 	void load_from_file(const std::string& filepath)
@@ -143,7 +166,7 @@ struct Mesh
 
 		file.close();
 
-		for (s32 i = 0; i < vertex_indices.size(); i++)
+		for (size_t i = 0; i < vertex_indices.size(); i++)
 		{
 			for (s32 j = 0; j < 3; j++)
 			{
@@ -195,9 +218,11 @@ struct Quad : public Mesh
 	}
 };
 
+// Triangles for filled drawing, or with lines every edge of the
+// triangulation once as a GL_LINES list
 struct Grid : public Mesh
 {
-	Grid(int w, int h, float spacing = 1.0f)
+	Grid(int w, int h, float spacing = 1.0f, bool lines = false)
 	{
 		vertices.clear();
 		indices.clear();
@@ -224,6 +249,24 @@ struct Grid : public Mesh
 			}
 		}
 
+		if (lines)
+		{
+			// Right, up and the cell's diagonal from each vertex
+			indices.reserve(static_cast<size_t>(w - 1) * (h - 1) * 6 + (w + h - 2) * 2);
+			for (int y = 0; y < h; ++y)
+			{
+				for (int x = 0; x < w; ++x)
+				{
+					int i = y * w + x;
+					if (x < w - 1) { indices.push_back(i); indices.push_back(i + 1); }
+					if (y < h - 1) { indices.push_back(i); indices.push_back(i + w); }
+					if (x < w - 1 && y < h - 1) { indices.push_back(i + 1); indices.push_back(i + w); }
+				}
+			}
+			setup_buffers();
+			return;
+		}
+
 		for (int y = 0; y < h - 1; ++y)
 		{
 			for (int x = 0; x < w - 1; ++x)
@@ -286,15 +329,15 @@ struct Sphere : public Mesh
 		for (u32 i = 0; i <= stack; i++)
 		{
 			f32 angle = PI / 2 - i * PI / stack;     // from pi/2 to -pi/2
-			f32 xy = radius * std::cosf(angle);      // r * cos(u)
-			f32 z  = radius * std::sinf(angle);      // r * sin(u)
+			f32 xy = radius * std::cos(angle);      // r * cos(u)
+			f32 z  = radius * std::sin(angle);      // r * sin(u)
 
 			for (u32 j = 0; j <= sector; j++)
 			{
 				f32 sectorAngle = j * 2 * PI / sector; // 0 to 2pi
 
-				f32 x = xy * std::cosf(sectorAngle);
-				f32 y = xy * std::sinf(sectorAngle);
+				f32 x = xy * std::cos(sectorAngle);
+				f32 y = xy * std::sin(sectorAngle);
 
 				glm::vec3 position = { x, y, z };
 				glm::vec3 normal   = glm::normalize(position);
@@ -396,6 +439,10 @@ struct Model
 	vf3 m_scale;
 	f32 m_angle;
 
+	// Set by prepare() for submit()
+	Shader* m_shader = nullptr;
+	UniformHandle m_model_handle = 0;
+
 	Model(const std::string& filepath)
 	{
 		m_model    = mf4x4(1.0f);
@@ -419,7 +466,36 @@ struct Model
 	void draw(std::shared_ptr<Shader> prisma_shader, s32 mode = GL_TRIANGLES)
 	{
 		prisma_shader->Use();
+		update_transform();
+		prisma_shader->SetUniform("model", m_model);
+		m_mesh.draw(mode);
+	}
+
+	// Render thread, resolves "model" once, the handle survives hot reloads
+	void prepare(Shader& prisma_shader)
+	{
+		m_shader = &prisma_shader;
+		m_model_handle = prisma_shader.GetHandle("model");
+	}
 
+	// Safe to call from worker threads, only reads what prepare() resolved
+	void submit(RenderQueue& queue, std::shared_ptr<Shader> prisma_shader, s32 mode = GL_TRIANGLES, RenderPass pass = PASS_OPAQUE, f32 depth = 0.0f)
+	{
+		if (prisma_shader.get() != m_shader)
+		{
+			std::cout << "ERROR: Model submitted with a shader it was not prepared for\n";
+			return;
+		}
+
+		update_transform();
+		DrawPacket p = m_mesh.packet(*prisma_shader, mode, pass, depth);
+		p.model_location = prisma_shader->GetLocation(m_model_handle);
+		p.model = m_model;
+		queue.Submit(std::move(p));
+	}
+
+	void update_transform()
+	{
 		m_model = mf4x4(1.0f);
 		m_model = glm::rotate(m_model, glm::radians(m_angle), { 1.0f, 0.0f, 0.0f });
 		m_model = glm::rotate(m_model, glm::radians(m_angle), { 0.0f, 1.0f, 0.0f });
@@ -427,10 +503,6 @@ struct Model
 
 		m_model = glm::translate(m_model, m_position);
 		m_model = glm::scale(m_model, m_scale);
-
-		prisma_shader->SetUniform("model", m_model);
-		m_mesh.draw(mode);
-		prisma_shader->Unuse();
 	}
 
 	void scale(vf3 scale) { m_scale *= scale; }
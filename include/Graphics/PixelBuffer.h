@@ -0,0 +1,56 @@
+/*
+	Pixel Buffer
+		CPU side RGBA8 pixel storage, row major, 4 bytes per pixel.
+		No GL dependency: Sprite uploads it to a texture, the benchmarks
+		use it directly.
+*/
+#pragma once
+
+#include <vector>
+
+#include "Core/Common.h"
+#include "Graphics/Color.h"
+
+struct PixelBuffer
+{
+	std::vector<u8> m_pixels;
+	s32 m_width = 0;
+	s32 m_height = 0;
+
+	PixelBuffer() {}
+
+	PixelBuffer(s32 width, s32 height)
+	{
+		Resize(width, height);
+	}
+
+	void Resize(s32 width, s32 height)
+	{
+		m_width = width;
+		m_height = height;
+		m_pixels.resize(m_width * m_height * 4, 0);
+	}
+
+	void SetPixel(s32 x, s32 y, u8 r, u8 g, u8 b, u8 a = 255)
+	{
+		if (x < 0 || x >= m_width || y < 0 || y >= m_height) 
+			return;
+
+		s32 idx = 4 * (y * m_width + x);
+		m_pixels[idx + 0] = r;
+		m_pixels[idx + 1] = g;
+		m_pixels[idx + 2] = b;
+		m_pixels[idx + 3] = a;
+	}
+
+	void Clear(Color c = { 0, 0, 0, 255 })
+	{
+		for (s32 x = 0; x < m_width; ++x)
+		{
+			for (s32 y = 0; y < m_height; ++y)
+			{
+				SetPixel(x, y, c.r, c.g, c.b, c.a);
+			}
+		}
+	}
+};
@@ -1,24 +1,12 @@
 #include "PostProcessor.h"
 
-PostProcessor::PostProcessor(s32 width, s32 height)
-{
-    // Create Framebuffer Object
-    glGenFramebuffers(1, &FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-
-    // Create framebuffer texture
-    glGenTextures(1, &framebuffer_texture);
-    glBindTexture(GL_TEXTURE_2D, framebuffer_texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, framebuffer_texture, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cerr << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!\n";
+#include <algorithm>
+#include <cmath>
+
+PostProcessor::PostProcessor(s32 width, s32 height, const SceneFormat& scene) : m_width(width), m_height(height)
+{
+    // Scene target
+    m_scene = m_pool.Acquire(width, height, scene.format, scene.depth, scene.samples);
 
     // Create quad
     verts = {
@@ -34,7 +22,7 @@ PostProcessor::PostProcessor(s32 width, s32 height)
 
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
+    RenderState::BindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(quad_vert), verts.data(), GL_STATIC_DRAW);
 
@@ -45,36 +33,432 @@ PostProcessor::PostProcessor(s32 width, s32 height)
     // Texture coordinate attribute
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(quad_vert), (void*)offsetof(quad_vert, uv));
-    glBindVertexArray(0);
+    RenderState::BindVertexArray(0);
 }
 
 PostProcessor::~PostProcessor() 
 {
-    glDeleteFramebuffers(1, &FBO);
-    glDeleteTextures(1, &framebuffer_texture);
+    RenderState::ForgetVertexArray(VAO);
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
 }
 
-void PostProcessor::Begin()
+void PostProcessor::Begin(f32 persistence)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    UpdateScale();
+
+    // Resize the scene target when the scale changed
+    s32 w = std::max(1, static_cast<s32>(m_width  * m_scale));
+    s32 h = std::max(1, static_cast<s32>(m_height * m_scale));
+    if (m_scene->width != w || m_scene->height != h)
+    {
+        RenderTarget* previous = m_scene;
+        m_pool.Release(previous);
+        m_scene = m_pool.Acquire(w, h, previous->format, previous->depth, previous->samples);
+        m_scene_fresh = true;
+    }
+
+    // A frame that neither rendered nor submitted left its query open
+    m_timer.End();
+    if (m_resolution.enabled)
+        m_timer.Begin();
+    m_scene->Bind();
+
+    GLbitfield depth = m_scene->depth ? GL_DEPTH_BUFFER_BIT : 0;
+    // A new target holds nothing worth fading
+    if (persistence <= 0.0f || m_scene_fresh)
+    {
+        m_scene_fresh = false;
+        glClearColor(m_clear_color.r, m_clear_color.g, m_clear_color.b, m_clear_color.a);
+        glClear(GL_COLOR_BUFFER_BIT | depth);
+        return;
+    }
+
+    // dst * persistence, the fragment color is ignored
+    if (!m_fade)
+        m_fade = std::make_shared<Shader>("res/shaders/post_processing/post_processing.vs", "res/shaders/post_processing/no_effect.fs");
+
+    if (depth)
+        glClear(depth);
+
+    // Scene drawing continues with whatever state the caller had set
+    bool blend = RenderState::IsEnabled(GL_BLEND);
+    bool depth_test = RenderState::IsEnabled(GL_DEPTH_TEST);
+    GLenum blend_src, blend_dst;
+    RenderState::GetBlendFunc(blend_src, blend_dst);
+
+    RenderState::Enable(GL_BLEND);
+    RenderState::Disable(GL_DEPTH_TEST);
+    RenderState::BlendFunc(GL_ZERO, GL_CONSTANT_COLOR);
+    glBlendColor(persistence, persistence, persistence, persistence);
+    m_fade->Use();
+    DrawQuad();
+
+    RenderState::BlendFunc(blend_src, blend_dst);
+    if (!blend)
+        RenderState::Disable(GL_BLEND);
+    if (depth_test)
+        RenderState::Enable(GL_DEPTH_TEST);
 }
 
 void PostProcessor::End()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindVertexArray(0);
+    RenderState::BindFramebuffer(0);
+    glViewport(0, 0, m_width, m_height);
 }
 
+void PostProcessor::SetClearColor(const vf4& color)
+{
+    m_clear_color = color;
+}
 
-void PostProcessor::Render()
+void PostProcessor::DrawQuad()
 {
-    glBindVertexArray(VAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, framebuffer_texture);
+    RenderState::BindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+void PostProcessor::Render()
+{
+    // Resolve right before the scene is read, the blit leaves the binding unknown
+    m_scene->Resolve();
+    RenderState::BindFramebuffer(0);
+
+    bool upscale = m_resolution.sharpness > 0.0f && (m_scene->width != m_width || m_scene->height != m_height);
+    RenderTarget* scene = m_scene;
+
+    if (m_passes.empty())
+    {
+        if (upscale)
+        {
+            Upscale(m_scene, true);
+        }
+        else
+        {
+            RenderState::BindTexture(0, m_scene->texture);
+            DrawQuad();
+        }
+        m_timer.End();
+        return;
+    }
+
+    if (upscale)
+        scene = Upscale(m_scene, false);
+
+    for (s32 i = 0; i < static_cast<s32>(m_passes.size()); i++)
+    {
+        PassState& state = m_passes[i];
+        Shader& shader = *state.pass.shader;
+
+        // Output
+        bool to_screen = i == static_cast<s32>(m_passes.size()) - 1;
+        if (to_screen)
+        {
+            state.output = nullptr;
+            RenderState::BindFramebuffer(0);
+            glViewport(0, 0, m_width, m_height);
+        }
+        else
+        {
+            s32 w = std::max(1, static_cast<s32>(m_width  * state.pass.scale));
+            s32 h = std::max(1, static_cast<s32>(m_height * state.pass.scale));
+            state.output = m_pool.Acquire(w, h, state.pass.format);
+            state.output->Bind();
+        }
+
+        shader.Use();
+
+        // Inputs
+        vf2 texel_size = { 1.0f / m_width, 1.0f / m_height };
+        for (size_t k = 0; k < state.sources.size(); k++)
+        {
+            RenderTarget* input = state.sources[k] == SCENE ? scene : m_passes[state.sources[k]].output;
+            RenderState::BindTexture(static_cast<u32>(k), input->texture);
+            shader.SetUniform(state.samplers[k], static_cast<s32>(k));
+            if (k == 0)
+                texel_size = { 1.0f / input->width, 1.0f / input->height };
+        }
+        shader.SetUniform(state.texel_size, texel_size);
+
+        if (state.pass.uniforms)
+            state.pass.uniforms(shader);
+
+        DrawQuad();
+
+        // Hand back targets nobody reads anymore
+        for (s32 source : state.sources)
+        {
+            if (source != SCENE && m_passes[source].last_reader == i && m_passes[source].output)
+            {
+                m_pool.Release(m_passes[source].output);
+                m_passes[source].output = nullptr;
+            }
+        }
+        if (state.output && state.last_reader < 0)
+        {
+            m_pool.Release(state.output);
+            state.output = nullptr;
+        }
+    }
+
+    if (scene != m_scene)
+        m_pool.Release(scene);
+
+    m_timer.End();
+}
+
+RenderTarget* PostProcessor::Upscale(RenderTarget* scene, bool to_screen)
+{
+    if (!m_upscale)
+        m_upscale = std::make_shared<Shader>("res/shaders/post_processing/post_processing.vs", "res/shaders/post_processing/upscale.fs");
+
+    RenderTarget* output = nullptr;
+    if (to_screen)
+    {
+        RenderState::BindFramebuffer(0);
+        glViewport(0, 0, m_width, m_height);
+    }
+    else
+    {
+        output = m_pool.Acquire(m_width, m_height, scene->format);
+        output->Bind();
+    }
+
+    m_upscale->Use();
+    RenderState::BindTexture(0, scene->texture);
+    m_upscale->SetUniform("screen_texture", 0);
+    m_upscale->SetUniform("texel_size", vf2(1.0f / scene->width, 1.0f / scene->height));
+    m_upscale->SetUniform("sharpness", m_resolution.sharpness);
+    DrawQuad();
+
+    return output;
+}
+
+void PostProcessor::UpdateScale()
+{
+    if (m_timer.Poll())
+    {
+        // Smooth out single slow frames
+        f32 ms = m_timer.Milliseconds();
+        m_gpu_ms = m_gpu_ms > 0.0f ? m_gpu_ms + (ms - m_gpu_ms) * 0.2f : ms;
+        m_frames_since_change++;
+    }
+
+    if (!m_resolution.enabled || m_gpu_ms <= 0.0f)
+        return;
+
+    // Results lag a few frames behind, wait until they reflect the last change
+    if (m_frames_since_change < 8)
+        return;
+
+    // Over budget, or enough headroom to grow
+    f32 budget = m_resolution.target_ms;
+    if (m_gpu_ms < budget && m_gpu_ms > budget * 0.8f)
+        return;
+
+    f32 scale = m_scale * std::sqrt(budget / m_gpu_ms);
+    scale = std::clamp(scale, m_resolution.min_scale, m_resolution.max_scale);
+    scale = std::round(scale * 32.0f) / 32.0f;
+    if (scale == m_scale)
+        return;
+
+    // Predict the new cost so the controller does not overshoot
+    m_gpu_ms *= (scale * scale) / (m_scale * m_scale);
+    m_scale = scale;
+    m_frames_since_change = 0;
+}
+
+DynamicResolution& PostProcessor::Resolution()
+{
+    return m_resolution;
+}
+
+void PostProcessor::SetRenderScale(f32 scale)
+{
+    m_scale = std::clamp(scale, 0.05f, 1.0f);
+}
+
+f32 PostProcessor::GetRenderScale() const
+{
+    return m_scale;
+}
+
+f32 PostProcessor::GetGpuTime() const
+{
+    return m_gpu_ms;
+}
+
+void PostProcessor::AddPass(const PostPass& pass)
+{
+    if (!pass.shader)
+    {
+        std::printf("ERROR: Post pass '%s' has no shader\n", pass.name.c_str());
+        return;
+    }
+
+    PassState state;
+    state.pass = pass;
+    s32 index = static_cast<s32>(m_passes.size());
+
+    for (const PostInput& input : pass.inputs)
+    {
+        s32 source = -2;
+        if (input.source == "scene")
+            source = SCENE;
+        for (s32 j = 0; j < index && source == -2; j++)
+            if (m_passes[j].pass.name == input.source)
+                source = j;
+
+        if (source == -2)
+        {
+            std::printf("ERROR: Post pass '%s' reads unknown input '%s'\n", pass.name.c_str(), input.source.c_str());
+            return;
+        }
+
+        if (source != SCENE)
+            m_passes[source].last_reader = index;
+        state.sources.push_back(source);
+        state.samplers.push_back(state.pass.shader->GetHandle(input.sampler));
+    }
+
+    state.texel_size = state.pass.shader->GetHandle("texel_size");
+    m_passes.push_back(std::move(state));
+}
+
+void PostProcessor::ClearPasses()
+{
+    m_passes.clear();
+}
+
+u32 PostProcessor::PassCount() const
+{
+    return static_cast<u32>(m_passes.size());
+}
+
+const RenderTargetPool& PostProcessor::GetPool() const
+{
+    return m_pool;
+}
+
+void PostProcessor::AddBloom(const std::string& source, bool composite)
+{
+    const std::string dir = "res/shaders/post_processing/";
+    if (!m_bloom_down)
+    {
+        m_bloom_down      = std::make_shared<Shader>(dir + "post_processing.vs", dir + "bloom_downsample.fs");
+        m_bloom_up        = std::make_shared<Shader>(dir + "post_processing.vs", dir + "bloom_upsample.fs");
+        m_gaussian        = std::make_shared<Shader>(dir + "post_processing.vs", dir + "gaussian.fs");
+        m_bloom_composite = std::make_shared<Shader>(dir + "post_processing.vs", dir + "bloom_composite.fs");
+    }
+
+    // Stop before the smallest level gets under a few pixels
+    u32 levels = 1;
+    while (levels < std::max(m_bloom.levels, 1u) && (std::min(m_width, m_height) >> (levels + 1)) >= 4)
+        levels++;
+
+    // Bloom levels accumulate above 1.0, keep them in float
+    const GLenum format = GL_R11F_G11F_B10F;
+
+    f32 scale = 1.0f;
+    std::vector<f32> scales;
+    std::string previous = source;
+    for (u32 i = 0; i < levels; i++)
+    {
+        scale *= 0.5f;
+        scales.push_back(scale);
+
+        PostPass down;
+        down.name   = "bloom_down" + std::to_string(i);
+        down.shader = m_bloom_down;
+        down.inputs = { { previous, "screen_texture" } };
+        down.scale  = scale;
+        down.format = format;
+        s32 prefilter = i == 0;
+        down.uniforms = [this, prefilter](Shader& s) {
+            s.SetUniform("prefilter", prefilter);
+            s.SetUniform("threshold", m_bloom.threshold);
+            s.SetUniform("knee", m_bloom.knee);
+        };
+        AddPass(down);
+        previous = down.name;
+    }
+
+    // Separable Gaussian on the smallest level
+    PostPass blur_h;
+    blur_h.name     = "bloom_blur_h";
+    blur_h.shader   = m_gaussian;
+    blur_h.inputs   = { { previous, "screen_texture" } };
+    blur_h.scale    = scale;
+    blur_h.format   = format;
+    blur_h.uniforms = [](Shader& s) { s.SetUniform("direction", vf2(1.0f, 0.0f)); };
+    AddPass(blur_h);
+
+    PostPass blur_v = blur_h;
+    blur_v.name     = levels == 1 ? "bloom" : "bloom_blur_v";
+    blur_v.inputs   = { { blur_h.name, "screen_texture" } };
+    blur_v.uniforms = [](Shader& s) { s.SetUniform("direction", vf2(0.0f, 1.0f)); };
+    AddPass(blur_v);
+    previous = blur_v.name;
+
+    // Tent upsample back to half resolution, adding each downsample level
+    for (s32 i = static_cast<s32>(levels) - 2; i >= 0; i--)
+    {
+        PostPass up;
+        up.name     = i == 0 ? "bloom" : "bloom_up" + std::to_string(i);
+        up.shader   = m_bloom_up;
+        up.inputs   = { { previous, "low_texture" }, { "bloom_down" + std::to_string(i), "current_texture" } };
+        up.scale    = scales[i];
+        up.format   = format;
+        up.uniforms = [this](Shader& s) { s.SetUniform("radius", m_bloom.radius); };
+        AddPass(up);
+        previous = up.name;
+    }
+
+    if (composite)
+    {
+        PostPass pass;
+        pass.name     = "bloom_composite";
+        pass.shader   = m_bloom_composite;
+        pass.inputs   = { { source, "screen_texture" }, { "bloom", "bloom_texture" } };
+        pass.uniforms = [this](Shader& s) { s.SetUniform("intensity", m_bloom.intensity); };
+        AddPass(pass);
+    }
+}
+
+BloomSettings& PostProcessor::Bloom()
+{
+    return m_bloom;
+}
+
+void PostProcessor::Submit(RenderQueue& queue, Shader& shader)
+{
+    DrawPacket p;
+    p.framebuffer = 0;
+    p.viewport    = vi4(0, 0, m_width, m_height);
+    p.depth_test  = false;
+    p.program     = shader.GetID();
+    p.vao         = VAO;
+    p.texture     = m_scene->texture;
+    p.indexed     = false;
+    p.count       = 6;
+    p.key         = RenderQueue::MakeKey(PASS_POST, p.program, p.texture, 0.0f);
+
+    // Scene packets sort before this one: resolve what they drew, then end the measurement
+    RenderTarget* scene = m_scene;
+    p.uniforms = [this, scene]() {
+        scene->Resolve();
+        RenderState::BindFramebuffer(0);
+        m_timer.End();
+    };
+    queue.Submit(std::move(p));
+}
+
+u32 PostProcessor::GetFramebuffer() const
+{
+    return m_scene->DrawFramebuffer();
+}
+
+vi4 PostProcessor::GetViewport() const
+{
+    return vi4(0, 0, m_scene->width, m_scene->height);
+}
@@ -1,10 +1,71 @@
+/*
+	Post Processing Pipeline
+		The scene is rendered into an offscreen target between Begin() and
+		End(). Render() then runs an ordered chain of full screen passes.
+
+	Scene Target
+		SceneFormat picks the color format (GL_RGB8 by default, GL_RGBA16F
+		or GL_R11F_G11F_B10F for HDR), an optional depth attachment and the
+		MSAA sample count. A multisampled scene is resolved right before it
+		is read, by Render() or by the Submit() packet once every queued
+		scene packet drew.
+		Begin() with a persistence above zero fades the previous frame
+		instead of clearing it, for trails that accumulate over frames.
+		Fading needs GL_RGBA16F: R11G11B10F keeps 5-6 mantissa bits, so
+		any persistence above ~0.99 rounds back to the same value and the
+		trails never clear.
+
+	Passes
+		Each pass has a shader, a list of inputs and one output. Inputs name
+		either the scene ("scene") or an earlier pass and are bound to
+		texture units in order, the sampler uniform of each input is set
+		automatically. The last pass draws to the default framebuffer, every
+		other pass draws into a target borrowed from a RenderTargetPool.
+		A target goes back to the pool right after its last reader, so a
+		chain of N passes usually ping-pongs between two targets.
+
+		Every pass also receives "texel_size", one over the size of its
+		first input, for kernels that step in pixels.
+
+		Without passes Render() draws the scene with the bound program.
+
+	Bloom
+		AddBloom() appends a bloom stage reading any earlier output. The
+		first 13 tap downsample applies a soft knee bright pass, each further
+		level halves the resolution, the smallest level gets a separable
+		9 tap Gaussian, and tent filtered upsamples add the levels back up.
+		Every pass does a fixed number of fetches per pixel, the blur radius
+		grows with the number of levels, not with the kernel size.
+		The result is published as "bloom" at half resolution, optionally
+		composited over the source by a final "bloom_composite" pass.
+		One bloom stage per chain.
+
+	Dynamic Resolution
+		The scene target can be rendered at a fraction of the window size.
+		With dynamic resolution enabled the GPU time from Begin() to the end
+		of Render(), or to the Submit() packet when the scene is queued, is
+		measured with timer queries and the scale is nudged
+		toward the frame budget: pixel cost grows with the square of the
+		scale, so the correction is the square root of budget over time.
+		Scales are quantized to 1/32 and every size is a pooled target, so
+		going back and forth does not allocate. The scene is upscaled
+		bilinearly when sampled, or by a sharpening pass when sharpness is
+		above zero. Pass scales stay relative to the window.
+*/
 #pragma once
 
 #include <glad/glad.h>
 #include <vector>
+#include <string>
+#include <memory>
+#include <functional>
 
 #include "Core/Common.h"
 #include "Graphics/Shader.h"
+#include "Graphics/RenderState.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/RenderTarget.h"
+#include "Graphics/GpuTimer.h"
 
 struct quad_vert
 {
@@ -12,28 +73,134 @@ struct quad_vert
     vf2 uv;
 };
 
+struct PostInput
+{
+    std::string source;  // "scene" or the name of an earlier pass
+    std::string sampler; // sampler2D uniform in the pass shader
+};
+
+struct SceneFormat
+{
+    GLenum format = GL_RGB8;
+    bool depth = false;
+    s32 samples = 0;
+};
+
+// Mirrors the bloom controls of SimpleCRTConfig
+struct BloomSettings
+{
+    f32 intensity = 0.5f;  // Bloom added over the source when compositing
+    f32 threshold = 0.15f; // Brightness where bloom starts
+    f32 knee = 0.1f;       // Width of the soft threshold transition
+    f32 radius = 1.0f;     // Upsample tent radius in texels
+    u32 levels = 5;        // Downsample levels, each one halves the resolution
+};
+
+struct DynamicResolution
+{
+    bool enabled = false;
+    f32 target_ms = 16.0f; // GPU budget for scene and post processing
+    f32 min_scale = 0.5f;
+    f32 max_scale = 1.0f;
+    f32 sharpness = 0.5f;  // 0 for a plain bilinear upscale
+};
+
+struct PostPass
+{
+    std::string name;
+    std::shared_ptr<Shader> shader;
+    std::vector<PostInput> inputs;
+    f32 scale = 1.0f;          // Output size relative to the scene
+    GLenum format = GL_RGBA8;  // Output internal format
+    std::function<void(Shader&)> uniforms = nullptr;
+};
+
 // 2D Post Processing Pipeline
 class PostProcessor
 {
 public:
-    PostProcessor(s32 width, s32 height);
+    PostProcessor(s32 width, s32 height, const SceneFormat& scene = {});
     ~PostProcessor();
 
 public:
-    // Call before scene rendering
-    void Begin();
+    // Call before scene rendering, the scene target is valid until the next Begin()
+    // persistence: 0 clears, otherwise the previous frame is multiplied by it
+    void Begin(f32 persistence = 0.0f);
 
-    // Call after scene rendering 
+    // Call after scene rendering, binds the default framebuffer
     void End();
 
+    void SetClearColor(const vf4& color);
+
     void Render();
 
+    // Deferred post pass, drawn after every scene packet
+    void Submit(RenderQueue& queue, Shader& shader);
+
+    // Scene packets target this framebuffer with this viewport
+    u32 GetFramebuffer() const;
+    vi4 GetViewport() const;
+
+public:
+    // Pass chain, run in the order added
+    void AddPass(const PostPass& pass);
+    void ClearPasses();
+    u32 PassCount() const;
+    const RenderTargetPool& GetPool() const;
+
+    // Bloom stage, settings are read every frame
+    void AddBloom(const std::string& source = "scene", bool composite = true);
+    BloomSettings& Bloom();
+
+    // Scene render scale, set manually or driven by dynamic resolution
+    DynamicResolution& Resolution();
+    void SetRenderScale(f32 scale);
+    f32 GetRenderScale() const;
+    f32 GetGpuTime() const;
+
+private:
+    void DrawQuad();
+    void UpdateScale();
+    RenderTarget* Upscale(RenderTarget* scene, bool to_screen);
+
 private:
-    u32 FBO;                 // Framebuffer object for screen
-    u32 framebuffer_texture; // The texture attached to the framebuffer
+    static constexpr s32 SCENE = -1;
+
+    struct PassState
+    {
+        PostPass pass;
+        std::vector<s32> sources;           // SCENE or pass index
+        std::vector<UniformHandle> samplers;
+        UniformHandle texel_size = 0;
+        s32 last_reader = -1;               // Last pass reading this output
+        RenderTarget* output = nullptr;
+    };
+
+    s32 m_width;
+    s32 m_height;
+
+    RenderTarget* m_scene = nullptr; // Owned by m_pool
+    bool m_scene_fresh = true;
+    vf4 m_clear_color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    std::vector<PassState> m_passes;
+    RenderTargetPool m_pool;
+
+    BloomSettings m_bloom;
+    std::shared_ptr<Shader> m_bloom_down;
+    std::shared_ptr<Shader> m_bloom_up;
+    std::shared_ptr<Shader> m_gaussian;
+    std::shared_ptr<Shader> m_bloom_composite;
+
+    DynamicResolution m_resolution;
+    std::shared_ptr<Shader> m_upscale;
+    std::shared_ptr<Shader> m_fade;
+    GpuTimer m_timer;
+    f32 m_scale = 1.0f;
+    f32 m_gpu_ms = 0.0f;
+    u32 m_frames_since_change = 0;
 
     // Quad
     u32 VAO; // Quad VAO
     u32 VBO; // Quad VBO
     std::vector<quad_vert> verts; // Quad Vertex data 
-};
\ No newline at end of file
+};
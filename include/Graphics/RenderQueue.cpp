@@ -0,0 +1,159 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+RenderQueue::RenderQueue(u32 capacity)
+{
+    m_packets.resize(capacity);
+}
+
+u64 RenderQueue::MakeKey(RenderPass pass, u32 program, u32 texture, f32 depth)
+{
+    // Depth is expected in [0, 1], quantized to 24 bits
+    u64 d = static_cast<u64>(std::clamp(depth, 0.0f, 1.0f) * 16777215.0f);
+    u64 p = static_cast<u64>(pass) & 0xF;
+    u64 s = static_cast<u64>(program) & 0xFFF;
+    u64 t = static_cast<u64>(texture) & 0xFFFF;
+
+    if (pass == PASS_TRANSPARENT)
+        return (p << 60) | ((0xFFFFFF - d) << 36) | (s << 24) | (t << 8);
+
+    return (p << 60) | (s << 48) | (t << 32) | (d << 8);
+}
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+    DrawPacket copy = packet;
+    Submit(std::move(copy));
+}
+
+void RenderQueue::Submit(DrawPacket&& packet)
+{
+    u32 slot = m_count.fetch_add(1, std::memory_order_relaxed);
+    if (slot < m_packets.size())
+    {
+        m_packets[slot] = std::move(packet);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_overflow_mutex);
+    m_overflow.push_back(std::move(packet));
+}
+
+u32 RenderQueue::Size() const
+{
+    return std::min<u32>(m_count.load(), static_cast<u32>(m_packets.size())) + static_cast<u32>(m_overflow.size());
+}
+
+void RenderQueue::Clear()
+{
+    u32 count = std::min<u32>(m_count.load(), static_cast<u32>(m_packets.size()));
+    for (u32 i = 0; i < count; i++)
+        m_packets[i].uniforms = nullptr;
+
+    m_count = 0;
+    m_overflow.clear();
+}
+
+void RenderQueue::Execute()
+{
+    // Fold overflow into storage, the next frame will fit
+    u32 count = std::min<u32>(m_count.load(), static_cast<u32>(m_packets.size()));
+    if (!m_overflow.empty())
+    {
+        m_packets.resize(count);
+        for (DrawPacket& packet : m_overflow)
+            m_packets.push_back(std::move(packet));
+        m_overflow.clear();
+        count = static_cast<u32>(m_packets.size());
+        m_packets.resize(count + count / 2);
+    }
+    m_count = count;
+
+    if (count == 0)
+        return;
+
+    Sort();
+
+    // The viewport is not cached by RenderState, only skip repeats here
+    vi4 viewport = vi4(-1);
+    for (u32 i = 0; i < count; i++)
+    {
+        const DrawPacket& packet = m_packets[m_order[i]];
+
+        RenderState::BindFramebuffer(packet.framebuffer);
+        if (packet.viewport.z > 0 && packet.viewport.w > 0 && packet.viewport != viewport)
+        {
+            glViewport(packet.viewport.x, packet.viewport.y, packet.viewport.z, packet.viewport.w);
+            viewport = packet.viewport;
+        }
+        if (packet.depth_test) RenderState::Enable(GL_DEPTH_TEST);
+        else                   RenderState::Disable(GL_DEPTH_TEST);
+        if (packet.cull_face)  RenderState::Enable(GL_CULL_FACE);
+        else                   RenderState::Disable(GL_CULL_FACE);
+        RenderState::PolygonMode(packet.polygon_mode);
+        RenderState::UseProgram(packet.program);
+        RenderState::BindVertexArray(packet.vao);
+        if (packet.texture != 0)
+            RenderState::BindTexture(0, packet.texture);
+        RenderState::BlendFunc(packet.blend_src, packet.blend_dst);
+
+        if (packet.model_location >= 0)
+            glUniformMatrix4fv(packet.model_location, 1, GL_FALSE, glm::value_ptr(packet.model));
+        if (packet.uniforms)
+            packet.uniforms();
+
+        if (packet.indexed)
+            glDrawElements(packet.mode, packet.count, GL_UNSIGNED_INT, (void*)(static_cast<size_t>(packet.first) * sizeof(u32)));
+        else
+            glDrawArrays(packet.mode, packet.first, packet.count);
+    }
+
+    Clear();
+}
+
+void RenderQueue::Sort()
+{
+    // LSD radix sort of (key, index) pairs, 8 bits per pass, stable so
+    // packets with equal keys keep their submission order
+    u32 count = m_count.load();
+    m_keys.resize(count);
+    m_order.resize(count);
+    m_keys_tmp.resize(count);
+    m_order_tmp.resize(count);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        m_keys[i]  = m_packets[i].key;
+        m_order[i] = i;
+    }
+
+    for (u32 shift = 0; shift < 64; shift += 8)
+    {
+        u32 histogram[256] = {};
+        for (u32 i = 0; i < count; i++)
+            histogram[(m_keys[i] >> shift) & 0xFF]++;
+
+        // All keys share this digit, nothing to do
+        if (histogram[(m_keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        u32 offset = 0;
+        for (u32 b = 0; b < 256; b++)
+        {
+            u32 n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+
+        for (u32 i = 0; i < count; i++)
+        {
+            u32 dst = histogram[(m_keys[i] >> shift) & 0xFF]++;
+            m_keys_tmp[dst]  = m_keys[i];
+            m_order_tmp[dst] = m_order[i];
+        }
+
+        m_keys.swap(m_keys_tmp);
+        m_order.swap(m_order_tmp);
+    }
+}
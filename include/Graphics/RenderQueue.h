@@ -0,0 +1,106 @@
+/*
+	Render Queue
+		Draws are recorded as packets instead of issuing GL calls immediately.
+		Execute() sorts the packets by a 64-bit key and submits them in one
+		go through RenderState, so program, texture and framebuffer changes
+		happen once per group instead of once per draw.
+
+	Sort Key
+		Opaque and post passes sort by state, then front to back:
+			[63..60] pass | [59..48] program | [47..32] texture | [31..8] depth | [7..0] unused
+		Transparent passes must blend back to front, depth goes first:
+			[63..60] pass | [59..36] inverted depth | [35..24] program | [23..8] texture
+
+	Packet State
+		Every packet carries the state it draws with: framebuffer, viewport,
+		depth test, face culling, polygon mode and blend func are applied
+		per packet, so a packet draws the same no matter what ran before it.
+		A viewport of zero size leaves the current one.
+
+	Threading
+		Submit() may be called from any thread between Execute() calls.
+		Slots are claimed with an atomic counter, packets that do not fit the
+		preallocated storage spill into a mutex protected overflow list.
+		Execute() must run on the render thread after all workers finished.
+*/
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+#include "Graphics/RenderState.h"
+
+enum RenderPass : u8
+{
+	PASS_OPAQUE      = 0,
+	PASS_TRANSPARENT = 1,
+	PASS_POST        = 2,
+	PASS_OVERLAY     = 3
+};
+
+struct DrawPacket
+{
+	u64 key = 0;
+
+	// State
+	u32 framebuffer = 0;
+	u32 program     = 0;
+	u32 vao         = 0;
+	u32 texture     = 0; // bound to unit 0, 0 for none
+	GLenum blend_src = GL_SRC_ALPHA;
+	GLenum blend_dst = GL_ONE_MINUS_SRC_ALPHA;
+	vi4 viewport     = vi4(0); // x, y, width, height
+	bool depth_test  = true;
+	bool cull_face   = false;
+	GLenum polygon_mode = GL_FILL;
+
+	// Draw
+	GLenum mode   = GL_TRIANGLES;
+	u32 count     = 0;
+	u32 first     = 0;
+	bool indexed  = true;
+
+	// Per draw uniforms
+	s32 model_location = -1;
+	mf4x4 model = mf4x4(1.0f);
+	std::function<void()> uniforms = nullptr;
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue(u32 capacity = 4096);
+
+public:
+	static u64 MakeKey(RenderPass pass, u32 program, u32 texture, f32 depth);
+
+	// Thread safe
+	void Submit(const DrawPacket& packet);
+	void Submit(DrawPacket&& packet);
+
+	// Render thread only
+	void Execute();
+	void Clear();
+	u32 Size() const;
+
+private:
+	void Sort();
+
+private:
+	std::vector<DrawPacket> m_packets;
+	std::atomic<u32> m_count = 0;
+
+	std::mutex m_overflow_mutex;
+	std::vector<DrawPacket> m_overflow;
+
+	// Radix sort scratch
+	std::vector<u64> m_keys;
+	std::vector<u32> m_order;
+	std::vector<u64> m_keys_tmp;
+	std::vector<u32> m_order_tmp;
+};
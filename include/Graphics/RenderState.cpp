@@ -0,0 +1,169 @@
+#include "RenderState.h"
+
+RenderState::State RenderState::s_state;
+RenderState::Stats RenderState::s_frame;
+RenderState::Stats RenderState::s_last_frame;
+
+void RenderState::UseProgram(u32 program)
+{
+    if (s_state.program == program) { s_frame.elided++; return; }
+    glUseProgram(program);
+    s_state.program = program;
+    s_frame.issued++;
+}
+
+void RenderState::BindVertexArray(u32 vao)
+{
+    if (s_state.vao == vao) { s_frame.elided++; return; }
+    glBindVertexArray(vao);
+    s_state.vao = vao;
+    s_frame.issued++;
+}
+
+void RenderState::BindFramebuffer(u32 fbo)
+{
+    if (s_state.fbo == fbo) { s_frame.elided++; return; }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    s_state.fbo = fbo;
+    s_frame.issued++;
+}
+
+void RenderState::BlitFramebuffer(u32 src, u32 dst, s32 width, s32 height, GLbitfield mask)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, src);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, mask, GL_NEAREST);
+    s_state.fbo = UNKNOWN;
+    s_frame.issued += 3;
+}
+
+void RenderState::BindTexture(u32 unit, u32 texture)
+{
+    if (unit >= MAX_TEXTURE_UNITS)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        s_state.active_unit = unit;
+        s_frame.issued += 2;
+        return;
+    }
+
+    if (s_state.textures[unit] == texture) { s_frame.elided++; return; }
+
+    if (s_state.active_unit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        s_state.active_unit = unit;
+        s_frame.issued++;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    s_state.textures[unit] = texture;
+    s_frame.issued++;
+}
+
+void RenderState::Enable(GLenum cap)  { SetCap(cap, true); }
+void RenderState::Disable(GLenum cap) { SetCap(cap, false); }
+
+void RenderState::SetCap(GLenum cap, bool enabled)
+{
+    for (size_t i = 0; i < CAPS.size(); i++)
+    {
+        if (CAPS[i] != cap)
+            continue;
+
+        if (s_state.caps[i] == static_cast<s8>(enabled)) { s_frame.elided++; return; }
+        s_state.caps[i] = static_cast<s8>(enabled);
+        break;
+    }
+
+    if (enabled) glEnable(cap);
+    else         glDisable(cap);
+    s_frame.issued++;
+}
+
+void RenderState::BlendFunc(GLenum src, GLenum dst)
+{
+    if (s_state.blend_src == src && s_state.blend_dst == dst) { s_frame.elided++; return; }
+    glBlendFunc(src, dst);
+    s_state.blend_src = src;
+    s_state.blend_dst = dst;
+    s_frame.issued++;
+}
+
+void RenderState::PolygonMode(GLenum mode)
+{
+    if (s_state.polygon_mode == mode) { s_frame.elided++; return; }
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+    s_state.polygon_mode = mode;
+    s_frame.issued++;
+}
+
+bool RenderState::IsEnabled(GLenum cap)
+{
+    for (size_t i = 0; i < CAPS.size(); i++)
+    {
+        if (CAPS[i] != cap)
+            continue;
+
+        if (s_state.caps[i] < 0)
+            s_state.caps[i] = static_cast<s8>(glIsEnabled(cap) == GL_TRUE);
+        return s_state.caps[i] != 0;
+    }
+
+    return glIsEnabled(cap) == GL_TRUE;
+}
+
+void RenderState::GetBlendFunc(GLenum& src, GLenum& dst)
+{
+    if (s_state.blend_src == UNKNOWN || s_state.blend_dst == UNKNOWN)
+    {
+        // Blend funcs are only ever set for RGB and alpha together
+        GLint value[2] = {};
+        glGetIntegerv(GL_BLEND_SRC_RGB, &value[0]);
+        glGetIntegerv(GL_BLEND_DST_RGB, &value[1]);
+        s_state.blend_src = static_cast<GLenum>(value[0]);
+        s_state.blend_dst = static_cast<GLenum>(value[1]);
+    }
+
+    src = s_state.blend_src;
+    dst = s_state.blend_dst;
+}
+
+// Deleting a bound object reverts the binding to 0
+void RenderState::ForgetProgram(u32 program)
+{
+    if (s_state.program == program) s_state.program = UNKNOWN;
+}
+
+void RenderState::ForgetVertexArray(u32 vao)
+{
+    if (s_state.vao == vao) s_state.vao = UNKNOWN;
+}
+
+void RenderState::ForgetFramebuffer(u32 fbo)
+{
+    if (s_state.fbo == fbo) s_state.fbo = UNKNOWN;
+}
+
+void RenderState::ForgetTexture(u32 texture)
+{
+    for (u32& bound : s_state.textures)
+        if (bound == texture) bound = UNKNOWN;
+}
+
+void RenderState::Invalidate()
+{
+    s_state = State();
+}
+
+void RenderState::EndFrame()
+{
+    s_last_frame = s_frame;
+    s_frame = Stats();
+}
+
+const RenderState::Stats& RenderState::LastFrame()
+{
+    return s_last_frame;
+}
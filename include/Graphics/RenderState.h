@@ -0,0 +1,104 @@
+/*
+	Render State Cache
+		Thin layer over the GL calls that change bindings and fixed function
+		state. The last value set is tracked per context and a call that would
+		not change anything is skipped. Bound program, vertex array,
+		framebuffer, textures per unit, enabled capabilities, blend function
+		and polygon mode are tracked.
+
+	Rules
+		Code that binds through RenderState must not bind the same state with
+		raw GL calls, otherwise the cache goes stale. Objects must be
+		forgotten when deleted since GL recycles names.
+		Invalidate() forgets everything, e.g. after third party code changed
+		state without restoring it.
+
+	Queries
+		IsEnabled() and GetBlendFunc() answer from the cache so temporary
+		state changes can be undone, unknown values are read back from GL
+		once and cached.
+
+	Counters
+		Issued and elided calls are counted per frame, EndFrame() publishes
+		them to LastFrame().
+*/
+#pragma once
+
+#include <array>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+
+class RenderState
+{
+public:
+	struct Stats
+	{
+		u64 issued = 0;
+		u64 elided = 0;
+	};
+
+public:
+	// Bindings
+	static void UseProgram(u32 program);
+	static void BindVertexArray(u32 vao);
+	static void BindFramebuffer(u32 fbo);
+	static void BindTexture(u32 unit, u32 texture);
+
+	// Binds read and draw framebuffers separately, the framebuffer binding
+	// is unknown afterwards
+	static void BlitFramebuffer(u32 src, u32 dst, s32 width, s32 height, GLbitfield mask);
+
+	// Fixed function state
+	static void Enable(GLenum cap);
+	static void Disable(GLenum cap);
+	static void BlendFunc(GLenum src, GLenum dst);
+	static void PolygonMode(GLenum mode);
+
+	// Current fixed function state
+	static bool IsEnabled(GLenum cap);
+	static void GetBlendFunc(GLenum& src, GLenum& dst);
+
+	// Object deletion
+	static void ForgetProgram(u32 program);
+	static void ForgetVertexArray(u32 vao);
+	static void ForgetFramebuffer(u32 fbo);
+	static void ForgetTexture(u32 texture);
+	static void Invalidate();
+
+	// Counters
+	static void EndFrame();
+	static const Stats& LastFrame();
+
+private:
+	static void SetCap(GLenum cap, bool enabled);
+
+	static constexpr u32 UNKNOWN = 0xFFFFFFFF;
+	static constexpr u32 MAX_TEXTURE_UNITS = 32;
+
+	// Capabilities tracked by the cache, anything else is always issued
+	static constexpr std::array<GLenum, 8> CAPS = {
+		GL_DEPTH_TEST, GL_BLEND, GL_MULTISAMPLE, GL_LINE_SMOOTH,
+		GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_PROGRAM_POINT_SIZE
+	};
+
+	struct State
+	{
+		u32 program      = UNKNOWN;
+		u32 vao          = UNKNOWN;
+		u32 fbo          = UNKNOWN;
+		u32 active_unit  = UNKNOWN;
+		std::array<u32, MAX_TEXTURE_UNITS> textures;
+		std::array<s8, CAPS.size()> caps; // -1 unknown, 0 disabled, 1 enabled
+		GLenum blend_src = UNKNOWN;
+		GLenum blend_dst = UNKNOWN;
+		GLenum polygon_mode = UNKNOWN;
+
+		State() { textures.fill(UNKNOWN); caps.fill(-1); }
+	};
+
+	static State s_state;
+	static Stats s_frame;
+	static Stats s_last_frame;
+};
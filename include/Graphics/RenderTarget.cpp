@@ -0,0 +1,155 @@
+#include "RenderTarget.h"
+
+#include <cstdio>
+#include <algorithm>
+
+// Pixel transfer format and type compatible with an internal format,
+// only used to allocate storage
+static void TransferFormat(GLenum internal_format, GLenum& format, GLenum& type)
+{
+    switch (internal_format)
+    {
+    case GL_RGBA16F:
+    case GL_RGBA32F:        format = GL_RGBA; type = GL_FLOAT; break;
+    case GL_RGB16F:
+    case GL_RGB32F:
+    case GL_R11F_G11F_B10F: format = GL_RGB;  type = GL_FLOAT; break;
+    case GL_RGB8:
+    case GL_RGB:            format = GL_RGB;  type = GL_UNSIGNED_BYTE; break;
+    default:                format = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+    }
+}
+
+RenderTarget::RenderTarget(s32 w, s32 h, GLenum internal_format, bool depth_attachment, s32 sample_count)
+    : width(w), height(h), format(internal_format), depth(depth_attachment), samples(sample_count > 1 ? sample_count : 0)
+{
+    GLenum pixel_format, pixel_type;
+    TransferFormat(format, pixel_format, pixel_type);
+
+    glGenFramebuffers(1, &fbo);
+    RenderState::BindFramebuffer(fbo);
+
+    glGenTextures(1, &texture);
+    RenderState::BindTexture(0, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, pixel_format, pixel_type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    // Depth only lives on the framebuffer that is drawn to
+    if (depth && samples == 0)
+    {
+        glGenRenderbuffers(1, &depth_rb);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_rb);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::printf("ERROR: Render target %dx%d is not complete\n", width, height);
+
+    if (samples > 0)
+    {
+        s32 max_samples = 0;
+        glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+        samples = std::min(samples, max_samples);
+
+        glGenFramebuffers(1, &msaa_fbo);
+        RenderState::BindFramebuffer(msaa_fbo);
+
+        glGenRenderbuffers(1, &color_rb);
+        glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rb);
+
+        if (depth)
+        {
+            glGenRenderbuffers(1, &depth_rb);
+            glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_rb);
+        }
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::printf("ERROR: Render target %dx%d with %d samples is not complete\n", width, height, samples);
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    RenderState::BindFramebuffer(0);
+}
+
+RenderTarget::~RenderTarget()
+{
+    RenderState::ForgetFramebuffer(fbo);
+    RenderState::ForgetFramebuffer(msaa_fbo);
+    RenderState::ForgetTexture(texture);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &texture);
+    if (msaa_fbo) glDeleteFramebuffers(1, &msaa_fbo);
+    if (color_rb) glDeleteRenderbuffers(1, &color_rb);
+    if (depth_rb) glDeleteRenderbuffers(1, &depth_rb);
+}
+
+void RenderTarget::Bind()
+{
+    RenderState::BindFramebuffer(DrawFramebuffer());
+    glViewport(0, 0, width, height);
+}
+
+u32 RenderTarget::DrawFramebuffer() const
+{
+    return samples > 0 ? msaa_fbo : fbo;
+}
+
+void RenderTarget::Resolve()
+{
+    if (samples == 0)
+        return;
+
+    RenderState::BlitFramebuffer(msaa_fbo, fbo, width, height, GL_COLOR_BUFFER_BIT);
+}
+
+RenderTarget* RenderTargetPool::Acquire(s32 width, s32 height, GLenum format, bool depth, s32 samples)
+{
+    // Sample counts are clamped to GL_MAX_SAMPLES on creation, so any
+    // multisampled target satisfies a multisampled request
+    samples = samples > 1 ? samples : 0;
+    for (Entry& entry : m_entries)
+    {
+        RenderTarget* t = entry.target.get();
+        bool same = t->width == width && t->height == height && t->format == format && t->depth == depth;
+        if (!entry.in_use && same && (t->samples == samples || (samples > 0 && t->samples > 0)))
+        {
+            entry.in_use = true;
+            return t;
+        }
+    }
+
+    std::printf("INFO: Render target %dx%d allocated (pool size %zu)\n", width, height, m_entries.size() + 1);
+    m_entries.push_back({ std::make_unique<RenderTarget>(width, height, format, depth, samples), true });
+    return m_entries.back().target.get();
+}
+
+void RenderTargetPool::Release(RenderTarget* target)
+{
+    for (Entry& entry : m_entries)
+    {
+        if (entry.target.get() == target)
+        {
+            entry.in_use = false;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::Clear()
+{
+    m_entries.clear();
+}
+
+u32 RenderTargetPool::Size() const
+{
+    return static_cast<u32>(m_entries.size());
+}
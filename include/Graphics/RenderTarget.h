@@ -0,0 +1,79 @@
+/*
+	Render Target
+		A framebuffer with a single color texture attachment. Internal
+		formats are passed straight to GL: GL_RGB8 and GL_RGBA8 for LDR,
+		GL_RGBA16F for HDR with alpha, GL_R11F_G11F_B10F for HDR color at
+		the bandwidth of RGBA8. R11G11B10F is too coarse for targets that
+		accumulate over frames, small changes round away.
+
+		An optional depth-stencil renderbuffer can be attached. With samples
+		above 1 drawing goes to multisampled renderbuffers on a second
+		framebuffer and Resolve() blits them into the texture, which is
+		always single sampled so it can be read by later passes.
+
+	Render Target Pool
+		Intermediate targets of the post processing chain are borrowed from
+		a pool instead of being created per pass. Acquire() returns a free
+		target with the same size and format, or creates one; Release()
+		hands it back for the next pass or the next frame. After the first
+		frame a chain allocates nothing.
+*/
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+#include "Graphics/RenderState.h"
+
+struct RenderTarget
+{
+    u32 fbo = 0;
+    u32 texture = 0;
+    s32 width = 0;
+    s32 height = 0;
+    GLenum format = GL_RGBA8;
+    bool depth = false;
+    s32 samples = 0;
+
+    // Multisampled storage, only with samples > 1
+    u32 msaa_fbo = 0;
+    u32 color_rb = 0;
+    u32 depth_rb = 0;
+
+    RenderTarget(s32 w, s32 h, GLenum internal_format, bool depth_attachment = false, s32 sample_count = 0);
+    ~RenderTarget();
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    // Binds the framebuffer drawing goes to and sets the viewport
+    void Bind();
+
+    // Framebuffer drawing goes to, the multisampled one if any
+    u32 DrawFramebuffer() const;
+
+    // Copies multisampled color into the texture, no-op without MSAA
+    void Resolve();
+};
+
+class RenderTargetPool
+{
+public:
+    RenderTarget* Acquire(s32 width, s32 height, GLenum format, bool depth = false, s32 samples = 0);
+    void Release(RenderTarget* target);
+
+    // Destroys every target, borrowed targets become invalid
+    void Clear();
+    u32 Size() const;
+
+private:
+    struct Entry
+    {
+        std::unique_ptr<RenderTarget> target;
+        bool in_use = false;
+    };
+    std::vector<Entry> m_entries;
+};
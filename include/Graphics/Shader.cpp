@@ -7,39 +7,73 @@ Shader::Shader()
 
 Shader::Shader(const std::string& vertex_path, const std::string& fragment_path)
 {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    m_vertex_path   = vertex_path;
+    m_fragment_path = fragment_path;
     m_id = glCreateProgram();
 
     std::string vertex_source   = LoadFromFile(vertex_path);
     std::string fragment_source = LoadFromFile(fragment_path);
 
+    // Program binary cache
+    std::string key;
+    if (s_cache_enabled && BinarySupported())
+    {
+        key = CacheKey(vertex_source, fragment_source);
+        if (LoadBinary(key))
+        {
+            Reflect();
+            std::chrono::duration<f64, std::milli> ms = std::chrono::high_resolution_clock::now() - t0;
+            std::printf("INFO: Shader cache hit: %s + %s (%.2f ms)\n", vertex_path.c_str(), fragment_path.c_str(), ms.count());
+            return;
+        }
+    }
+
     u32 vertex_shader = Compile(VERTEX, vertex_source);
     u32 fragment_shader = Compile(FRAGMENT, fragment_source);
 
     Attach(vertex_shader);
     Attach(fragment_shader);
 
-    Link();
+    if (!key.empty())
+        glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    bool linked = Link();
 
-    Detach(vertex_shader);
-    Detach(fragment_shader);
+    if (linked)
+    {
+        Detach(vertex_shader);
+        Detach(fragment_shader);
+    }
 
     Delete(vertex_shader);
     Delete(fragment_shader);
+
+    if (linked)
+        Reflect();
+
+    if (linked && !key.empty())
+        SaveBinary(key);
+
+    std::chrono::duration<f64, std::milli> ms = std::chrono::high_resolution_clock::now() - t0;
+    std::printf("INFO: Shader compiled: %s + %s (%.2f ms)\n", vertex_path.c_str(), fragment_path.c_str(), ms.count());
 }
 
 Shader::~Shader()
 {
+    RenderState::ForgetProgram(m_id);
     glDeleteProgram(m_id);
 }
 
 void Shader::Use()
 {
-    glUseProgram(m_id);
+    RenderState::UseProgram(m_id);
 }
 
 void Shader::Unuse()
 {
-    glUseProgram(0);
+    RenderState::UseProgram(0);
 }
 
 u32 Shader::GetID()
@@ -47,12 +81,25 @@ u32 Shader::GetID()
     return m_id;
 }
 
+const std::string& Shader::GetVertexPath() const
+{
+    return m_vertex_path;
+}
+
+const std::string& Shader::GetFragmentPath() const
+{
+    return m_fragment_path;
+}
+
 std::string Shader::LoadFromFile(const std::string& filepath)
 {
     std::string data;
     std::ifstream file(filepath, std::ios::in | std::ios::binary);
     if (!file.is_open())
-        std::cout << "Could not open: " << filepath << "\n";
+    {
+        std::cout << "ERROR: Could not open: " << filepath << "\n";
+        return data;
+    }
 
     std::copy(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), std::back_inserter(data));
     file.close();
@@ -93,7 +140,7 @@ void Shader::Attach(u32& prisma_shader)
     glAttachShader(m_id, prisma_shader);
 }
 
-void Shader::Link()
+bool Shader::Link()
 {
     glLinkProgram(m_id);
 
@@ -110,7 +157,10 @@ void Shader::Link()
         glDeleteProgram(m_id);
 
         std::printf("%s\n", &(vErrorLog[0]));
+        return false;
     }
+
+    return true;
 }
 
 void Shader::Detach(u32& prisma_shader)
@@ -123,27 +173,239 @@ void Shader::Delete(u32& prisma_shader)
     glDeleteShader(prisma_shader);
 }
 
+void Shader::SetCacheDirectory(const std::string& directory)
+{
+    s_cache_directory = directory;
+}
+
+void Shader::EnableCache(bool enable)
+{
+    s_cache_enabled = enable;
+}
+
+bool Shader::BinarySupported()
+{
+    // glGetProgramBinary is core since 4.1 (ARB_get_program_binary)
+    if (glGetProgramBinary == nullptr || glProgramBinary == nullptr || glProgramParameteri == nullptr)
+        return false;
+
+    s32 formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+std::string Shader::CacheKey(const std::string& vertex_source, const std::string& fragment_source)
+{
+    // FNV-1a over sources and driver identification
+    u64 hash = 14695981039346656037ull;
+    auto combine = [&](const char* data, size_t size) {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<u8>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        // Separator so "ab"+"c" and "a"+"bc" differ
+        hash ^= 0xFF;
+        hash *= 1099511628211ull;
+    };
+
+    auto gl_string = [](GLenum name) {
+        const char* str = reinterpret_cast<const char*>(glGetString(name));
+        return std::string(str ? str : "");
+    };
+
+    std::string vendor   = gl_string(GL_VENDOR);
+    std::string renderer = gl_string(GL_RENDERER);
+    std::string version  = gl_string(GL_VERSION);
+
+    combine(vendor.data(),          vendor.size());
+    combine(renderer.data(),        renderer.size());
+    combine(version.data(),         version.size());
+    combine(vertex_source.data(),   vertex_source.size());
+    combine(fragment_source.data(), fragment_source.size());
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    return key;
+}
+
+bool Shader::LoadBinary(const std::string& key)
+{
+    std::filesystem::path path = std::filesystem::path(s_cache_directory) / (key + ".bin");
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    // Header: binary format followed by the program binary
+    u32 format = 0;
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    if (binary.empty())
+        return false;
+
+    glProgramBinary(m_id, format, binary.data(), static_cast<s32>(binary.size()));
+
+    s32 status = 0;
+    glGetProgramiv(m_id, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        // Driver rejected the binary, start over with a fresh program
+        std::printf("WARNING: Shader cache rejected: %s\n", path.string().c_str());
+        glDeleteProgram(m_id);
+        m_id = glCreateProgram();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool Shader::SaveBinary(const std::string& key)
+{
+    s32 length = 0;
+    glGetProgramiv(m_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+
+    std::vector<char> binary(length);
+    u32 format = 0;
+    glGetProgramBinary(m_id, length, &length, &format, binary.data());
+    if (length <= 0)
+        return false;
+
+    std::error_code ec;
+    std::filesystem::create_directories(s_cache_directory, ec);
+
+    std::filesystem::path path = std::filesystem::path(s_cache_directory) / (key + ".bin");
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::printf("WARNING: Could not write shader cache: %s\n", path.string().c_str());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    file.write(binary.data(), length);
+    return true;
+}
+
 u32 Shader::GetAttribute(const std::string& name) const
 {
     return glGetAttribLocation(m_id, name.c_str());
 }
 
-u32 Shader::GetUniform(const std::string& name) const
+u32 Shader::GetUniform(std::string_view name) const
 {
-    if (m_UniformLocations.find(name) != m_UniformLocations.end())
-        return m_UniformLocations[name];
+    auto it = m_UniformLocations.find(name);
+    if (it != m_UniformLocations.end())
+        return it->second;
 
-    u32 location = glGetUniformLocation(m_id, name.c_str());
-    m_UniformLocations[name] = location;
+    std::string key(name);
+    u32 location = glGetUniformLocation(m_id, key.c_str());
+    m_UniformLocations.emplace(std::move(key), location);
     return location;
 }
 
-void Shader::SetUniform(const std::string& name, const s32& val)       { glUniform1i(GetUniform(name), val); }
-void Shader::SetUniform(const std::string& name, f32* val, s32 count)  { glUniform1fv(GetUniform(name), count, val); }
-void Shader::SetUniform(const std::string& name, s32* val, s32 count)  { glUniform1iv(GetUniform(name), count, val); }
-void Shader::SetUniform(const std::string& name, const f64& val)       { glUniform1f(GetUniform(name), val); }
-void Shader::SetUniform(const std::string& name, const f32& val)       { glUniform1f(GetUniform(name), val); }
-void Shader::SetUniform(const std::string& name, const vf2& vector)    { glUniform2f(GetUniform(name), vector.x, vector.y); }
-void Shader::SetUniform(const std::string& name, const vf3& vector)    { glUniform3f(GetUniform(name), vector.x, vector.y, vector.z); }
-void Shader::SetUniform(const std::string& name, const vf4& vector)    { glUniform4f(GetUniform(name), vector.x, vector.y, vector.z, vector.w); }
-void Shader::SetUniform(const std::string& name, const mf4x4& matrix)  { glUniformMatrix4fv(GetUniform(name), 1, GL_FALSE, glm::value_ptr(matrix)); }
\ No newline at end of file
+void Shader::SetUniform(std::string_view name, const s32& val)       { glUniform1i(GetUniform(name), val); }
+void Shader::SetUniform(std::string_view name, f32* val, s32 count)  { glUniform1fv(GetUniform(name), count, val); }
+void Shader::SetUniform(std::string_view name, s32* val, s32 count)  { glUniform1iv(GetUniform(name), count, val); }
+void Shader::SetUniform(std::string_view name, const f64& val)       { glUniform1f(GetUniform(name), val); }
+void Shader::SetUniform(std::string_view name, const f32& val)       { glUniform1f(GetUniform(name), val); }
+void Shader::SetUniform(std::string_view name, const vf2& vector)    { glUniform2f(GetUniform(name), vector.x, vector.y); }
+void Shader::SetUniform(std::string_view name, const vf3& vector)    { glUniform3f(GetUniform(name), vector.x, vector.y, vector.z); }
+void Shader::SetUniform(std::string_view name, const vf4& vector)    { glUniform4f(GetUniform(name), vector.x, vector.y, vector.z, vector.w); }
+void Shader::SetUniform(std::string_view name, const mf4x4& matrix)  { glUniformMatrix4fv(GetUniform(name), 1, GL_FALSE, glm::value_ptr(matrix)); }
+
+void Shader::Reflect()
+{
+    m_UniformLocations.clear();
+
+    // Active uniforms, members of uniform blocks report location -1
+    s32 count = 0, max_length = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<char> name(std::max(max_length, 1));
+    for (s32 i = 0; i < count; i++)
+    {
+        s32 length = 0, size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_id, i, max_length, &length, &size, &type, name.data());
+        s32 location = glGetUniformLocation(m_id, name.data());
+        if (location < 0)
+            continue;
+
+        std::string uniform(name.data(), length);
+        m_UniformLocations[uniform] = location;
+
+        // Arrays are reported as "name[0]", also accept "name"
+        if (uniform.ends_with("[0]"))
+            m_UniformLocations[uniform.substr(0, uniform.size() - 3)] = location;
+    }
+
+    // Uniform blocks
+    s32 blocks = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_BLOCKS, &blocks);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_length);
+    name.resize(std::max(max_length, 1));
+    for (s32 i = 0; i < blocks; i++)
+    {
+        s32 length = 0, size = 0;
+        glGetActiveUniformBlockName(m_id, i, max_length, &length, name.data());
+        glGetActiveUniformBlockiv(m_id, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+
+        auto it = s_blocks.find(std::string(name.data(), length));
+        if (it == s_blocks.end())
+            continue;
+
+        glUniformBlockBinding(m_id, i, it->second.binding);
+        if (static_cast<u32>(size) > it->second.size)
+            std::printf("WARNING: Uniform block %s is %d bytes in shader but %u bytes in C++, check std140 layout\n", name.data(), size, it->second.size);
+    }
+
+    // Re-resolve handles, program may have been rebuilt
+    for (size_t h = 0; h < m_handle_names.size(); h++)
+    {
+        auto it = m_UniformLocations.find(m_handle_names[h]);
+        m_handle_locations[h] = it != m_UniformLocations.end() ? static_cast<s32>(it->second) : -1;
+    }
+}
+
+UniformHandle Shader::GetHandle(std::string_view name)
+{
+    for (size_t h = 0; h < m_handle_names.size(); h++)
+        if (m_handle_names[h] == name)
+            return static_cast<UniformHandle>(h);
+
+    m_handle_names.emplace_back(name);
+    m_handle_locations.push_back(static_cast<s32>(GetUniform(name)));
+    return static_cast<UniformHandle>(m_handle_names.size() - 1);
+}
+
+s32 Shader::GetLocation(UniformHandle handle) const
+{
+    return m_handle_locations[handle];
+}
+
+void Shader::SetUniform(UniformHandle handle, const s32& val)       { glUniform1i(m_handle_locations[handle], val); }
+void Shader::SetUniform(UniformHandle handle, f32* val, s32 count)  { glUniform1fv(m_handle_locations[handle], count, val); }
+void Shader::SetUniform(UniformHandle handle, s32* val, s32 count)  { glUniform1iv(m_handle_locations[handle], count, val); }
+void Shader::SetUniform(UniformHandle handle, const f32& val)       { glUniform1f(m_handle_locations[handle], val); }
+void Shader::SetUniform(UniformHandle handle, const vf2& vector)    { glUniform2f(m_handle_locations[handle], vector.x, vector.y); }
+void Shader::SetUniform(UniformHandle handle, const vf3& vector)    { glUniform3f(m_handle_locations[handle], vector.x, vector.y, vector.z); }
+void Shader::SetUniform(UniformHandle handle, const vf4& vector)    { glUniform4f(m_handle_locations[handle], vector.x, vector.y, vector.z, vector.w); }
+void Shader::SetUniform(UniformHandle handle, const mf4x4& matrix)  { glUniformMatrix4fv(m_handle_locations[handle], 1, GL_FALSE, glm::value_ptr(matrix)); }
+
+void Shader::BindBlock(const std::string& name, u32 binding)
+{
+    u32 index = glGetUniformBlockIndex(m_id, name.c_str());
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_id, index, binding);
+}
+
+void Shader::RegisterBlock(const std::string& name, u32 binding, u32 size)
+{
+    s_blocks[name] = { binding, size };
+}
\ No newline at end of file
@@ -10,20 +10,42 @@
 		Attach : attach shader to program
 		Link   : link shader to program
 		Use    : use shader program
+
+	Program Binary Cache
+		Linked programs are stored on disk with glGetProgramBinary, keyed by
+		source hash, driver vendor, renderer and version. On the next launch
+		glProgramBinary restores the program and skips compile and link.
+		Rejected binaries (driver update, corrupted file) fall back to source.
+
+	Hot Reload
+		See ShaderLibrary: watched shaders are rebuilt in the background and
+		the program id is swapped in place once the new program has linked.
+
+	Uniform Reflection
+		Active uniforms and uniform blocks are reflected after every link.
+		GetHandle resolves a name once into an integer handle that stays valid
+		across hot reloads; SetUniform(handle, ...) is an array lookup.
+		Uniform blocks registered through UniformBuffer are bound to their
+		binding point automatically.
 */
 #pragma once
 
 #include <string>
-#include <print>
 #include <fstream>
 #include <vector>
 #include <iostream>
 #include <unordered_map>
+#include <filesystem>
+#include <chrono>
+#include <string_view>
 
 #include <glad/glad.h>
 
 #include "Core/Common.h"
+#include "Graphics/RenderState.h"
+
 
+using UniformHandle = u32;
 
 enum ShaderType
 {
@@ -43,29 +65,81 @@ public:
 	void Use();
 	void Unuse();
 	u32 GetID();
+	const std::string& GetVertexPath() const;
+	const std::string& GetFragmentPath() const;
 
 public:
 	std::string LoadFromFile(const std::string& filepath);
 	u32 Compile(ShaderType type, std::string& source);
 	void Attach(u32& prisma_shader);
-	void Link();
+	bool Link();
 	void Detach(u32& prisma_shader);
 	void Delete(u32& prisma_shader);
 
 public:
 	u32 GetAttribute(const std::string& name) const;
-	u32 GetUniform(const std::string& name)  const;
-	void SetUniform(const std::string& name, const s32& val);
-	void SetUniform(const std::string& name, f32* val, s32 count);
-	void SetUniform(const std::string& name, s32* val, s32 count);
-	void SetUniform(const std::string& name, const f64& val);
-	void SetUniform(const std::string& name, const f32& val);
-	void SetUniform(const std::string& name, const vf2& vector);
-	void SetUniform(const std::string& name, const vf3& vector);
-	void SetUniform(const std::string& name, const vf4& vector);
-	void SetUniform(const std::string& name, const mf4x4& matrix);
+	u32 GetUniform(std::string_view name)  const;
+	void SetUniform(std::string_view name, const s32& val);
+	void SetUniform(std::string_view name, f32* val, s32 count);
+	void SetUniform(std::string_view name, s32* val, s32 count);
+	void SetUniform(std::string_view name, const f64& val);
+	void SetUniform(std::string_view name, const f32& val);
+	void SetUniform(std::string_view name, const vf2& vector);
+	void SetUniform(std::string_view name, const vf3& vector);
+	void SetUniform(std::string_view name, const vf4& vector);
+	void SetUniform(std::string_view name, const mf4x4& matrix);
+
+public:
+	// Reflection
+	void Reflect();
+	UniformHandle GetHandle(std::string_view name);
+	s32 GetLocation(UniformHandle handle) const; // No GL call, safe from worker threads
+	void SetUniform(UniformHandle handle, const s32& val);
+	void SetUniform(UniformHandle handle, f32* val, s32 count);
+	void SetUniform(UniformHandle handle, s32* val, s32 count);
+	void SetUniform(UniformHandle handle, const f32& val);
+	void SetUniform(UniformHandle handle, const vf2& vector);
+	void SetUniform(UniformHandle handle, const vf3& vector);
+	void SetUniform(UniformHandle handle, const vf4& vector);
+	void SetUniform(UniformHandle handle, const mf4x4& matrix);
+
+	// Uniform blocks
+	void BindBlock(const std::string& name, u32 binding);
+	static void RegisterBlock(const std::string& name, u32 binding, u32 size);
+
+public:
+	// Program binary cache
+	static void SetCacheDirectory(const std::string& directory);
+	static void EnableCache(bool enable);
+	bool LoadBinary(const std::string& key);
+	bool SaveBinary(const std::string& key);
+
+private:
+	static bool BinarySupported();
+	static std::string CacheKey(const std::string& vertex_source, const std::string& fragment_source);
 
 private:
-	u32 m_id;
-	mutable std::unordered_map<std::string, u32> m_UniformLocations;
+	friend class ShaderLibrary;
+
+	u32 m_id = 0;
+	std::string m_vertex_path;
+	std::string m_fragment_path;
+
+	// Transparent hash, lookups with string_view do not allocate
+	struct StringHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+	};
+	mutable std::unordered_map<std::string, u32, StringHash, std::equal_to<>> m_UniformLocations;
+
+	// Handle -> name is stable, handle -> location is rebuilt by Reflect
+	std::vector<std::string> m_handle_names;
+	std::vector<s32> m_handle_locations;
+
+	struct BlockInfo { u32 binding; u32 size; };
+	static inline std::unordered_map<std::string, BlockInfo> s_blocks;
+
+	static inline std::string s_cache_directory = "res/shaders/cache";
+	static inline bool s_cache_enabled = true;
 };
@@ -0,0 +1,307 @@
+#include "ShaderLibrary.h"
+
+#include <glfw3.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+// GL_KHR_parallel_shader_compile
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+ShaderLibrary::ShaderLibrary(const std::string& directory)
+{
+    m_directory = directory;
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    StopWatcher();
+
+    // Builds still compiling are never swapped in
+    for (PendingBuild& build : m_pending)
+        Abandon(build);
+    m_pending.clear();
+}
+
+std::shared_ptr<Shader> ShaderLibrary::Load(const std::string& name, const std::string& vertex_path, const std::string& fragment_path)
+{
+    auto shader = std::make_shared<Shader>(vertex_path, fragment_path);
+    m_shaders[name] = shader;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_watched_files.push_back(Normalize(vertex_path));
+        m_watched_files.push_back(Normalize(fragment_path));
+    }
+
+    if (m_hot_reload && !m_running)
+        StartWatcher();
+
+    return shader;
+}
+
+std::shared_ptr<Shader> ShaderLibrary::Get(const std::string& name) const
+{
+    auto it = m_shaders.find(name);
+    return it != m_shaders.end() ? it->second : nullptr;
+}
+
+void ShaderLibrary::SetHotReload(bool enable)
+{
+    m_hot_reload = enable;
+    if (enable && !m_running && !m_shaders.empty()) StartWatcher();
+    if (!enable) StopWatcher();
+}
+
+void ShaderLibrary::Update()
+{
+    // Drain the watcher queue
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        changed.swap(m_changed);
+    }
+
+    for (const std::string& path : changed)
+    {
+        for (auto& [name, shader] : m_shaders)
+        {
+            if (Normalize(shader->GetVertexPath()) == path || Normalize(shader->GetFragmentPath()) == path)
+                Rebuild(shader);
+        }
+    }
+
+    // Swap in programs that finished linking
+    for (size_t i = 0; i < m_pending.size();)
+    {
+        if (Poll(m_pending[i]))
+        {
+            m_pending[i] = m_pending.back();
+            m_pending.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void ShaderLibrary::Rebuild(const std::shared_ptr<Shader>& shader)
+{
+    // A newer edit supersedes a build still in flight
+    for (size_t i = 0; i < m_pending.size(); i++)
+    {
+        if (m_pending[i].shader == shader)
+        {
+            Abandon(m_pending[i]);
+            m_pending[i] = m_pending.back();
+            m_pending.pop_back();
+            break;
+        }
+    }
+
+    std::string vertex_source   = shader->LoadFromFile(shader->GetVertexPath());
+    std::string fragment_source = shader->LoadFromFile(shader->GetFragmentPath());
+    if (vertex_source.empty() || fragment_source.empty())
+        return;
+
+    auto compile = [](GLenum type, const std::string& source) {
+        u32 id = glCreateShader(type);
+        const char* src = source.c_str();
+        glShaderSource(id, 1, &src, nullptr);
+        glCompileShader(id);
+        return id;
+    };
+
+    // Issue compile and link without querying status, so drivers
+    // with parallel compilation can do the work off the render thread
+    PendingBuild build;
+    build.shader   = shader;
+    build.vertex   = compile(GL_VERTEX_SHADER, vertex_source);
+    build.fragment = compile(GL_FRAGMENT_SHADER, fragment_source);
+    build.program  = glCreateProgram();
+    glAttachShader(build.program, build.vertex);
+    glAttachShader(build.program, build.fragment);
+    glLinkProgram(build.program);
+
+    m_pending.push_back(build);
+}
+
+bool ShaderLibrary::Poll(PendingBuild& build)
+{
+    if (m_parallel_compile)
+    {
+        s32 done = GL_FALSE;
+        glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &done);
+        if (done == GL_FALSE)
+            return false;
+    }
+
+    s32 status = GL_FALSE;
+    glGetProgramiv(build.program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        auto print_log = [](u32 id, bool program) {
+            s32 length = 0;
+            if (program) glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
+            else         glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+            if (length <= 1) return;
+
+            std::vector<char> log(length);
+            if (program) glGetProgramInfoLog(id, length, &length, log.data());
+            else         glGetShaderInfoLog(id, length, &length, log.data());
+            std::printf("%s\n", log.data());
+        };
+
+        std::printf("ERROR: Shader reload failed, keeping previous program: %s + %s\n",
+            build.shader->GetVertexPath().c_str(), build.shader->GetFragmentPath().c_str());
+        print_log(build.vertex, false);
+        print_log(build.fragment, false);
+        print_log(build.program, true);
+        Abandon(build);
+        return true;
+    }
+
+    glDetachShader(build.program, build.vertex);
+    glDetachShader(build.program, build.fragment);
+    glDeleteShader(build.vertex);
+    glDeleteShader(build.fragment);
+
+    // Swap the live program
+    Shader& shader = *build.shader;
+    RenderState::ForgetProgram(shader.m_id);
+    glDeleteProgram(shader.m_id);
+    shader.m_id = build.program;
+    shader.Reflect();
+
+    std::printf("INFO: Shader reloaded: %s + %s\n", shader.GetVertexPath().c_str(), shader.GetFragmentPath().c_str());
+    return true;
+}
+
+void ShaderLibrary::Abandon(PendingBuild& build)
+{
+    glDeleteProgram(build.program);
+    glDeleteShader(build.vertex);
+    glDeleteShader(build.fragment);
+}
+
+void ShaderLibrary::StartWatcher()
+{
+    // Let the driver use as many compiler threads as it likes
+    auto max_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+    if (!max_threads)
+        max_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+
+    m_parallel_compile = max_threads != nullptr &&
+        (glfwExtensionSupported("GL_KHR_parallel_shader_compile") || glfwExtensionSupported("GL_ARB_parallel_shader_compile"));
+    if (m_parallel_compile)
+        max_threads(0xFFFFFFFF);
+
+    m_running = true;
+    m_watcher = std::thread(&ShaderLibrary::Watch, this);
+    std::printf("INFO: Watching shaders in %s (parallel compile: %s)\n", m_directory.string().c_str(), m_parallel_compile ? "yes" : "no");
+}
+
+void ShaderLibrary::StopWatcher()
+{
+    m_running = false;
+    if (m_watcher.joinable())
+        m_watcher.join();
+}
+
+#if defined(__linux__)
+void ShaderLibrary::Watch()
+{
+    s32 fd = inotify_init1(IN_NONBLOCK);
+    if (fd < 0)
+    {
+        std::printf("ERROR: inotify_init1 failed, shader hot reload disabled\n");
+        return;
+    }
+
+    // inotify is not recursive, watch every subdirectory
+    std::unordered_map<s32, std::filesystem::path> directories;
+    auto add_watch = [&](const std::filesystem::path& dir) {
+        s32 wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) directories[wd] = dir;
+    };
+
+    std::error_code ec;
+    add_watch(m_directory);
+    for (auto& entry : std::filesystem::recursive_directory_iterator(m_directory, ec))
+        if (entry.is_directory()) add_watch(entry.path());
+
+    alignas(inotify_event) char buffer[4096];
+    while (m_running)
+    {
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        for (ssize_t i = 0; i < length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + i);
+            i += sizeof(inotify_event) + event->len;
+
+            auto it = directories.find(event->wd);
+            if (it == directories.end() || event->len == 0)
+                continue;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_changed.push_back(Normalize(it->second / event->name));
+        }
+    }
+
+    close(fd);
+}
+#else
+void ShaderLibrary::Watch()
+{
+    // Portable fallback: poll modification times of the loaded files
+    std::unordered_map<std::string, std::filesystem::file_time_type> timestamps;
+    while (m_running)
+    {
+        std::vector<std::string> files;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            files = m_watched_files;
+        }
+
+        for (const std::string& file : files)
+        {
+            std::error_code ec;
+            auto time = std::filesystem::last_write_time(file, ec);
+            if (ec) continue;
+
+            auto it = timestamps.find(file);
+            if (it == timestamps.end())
+            {
+                timestamps[file] = time;
+            }
+            else if (it->second != time)
+            {
+                it->second = time;
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_changed.push_back(file);
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+}
+#endif
+
+std::string ShaderLibrary::Normalize(const std::filesystem::path& path)
+{
+    return path.lexically_normal().generic_string();
+}
@@ -0,0 +1,81 @@
+/*
+	Shader Library
+		Owns named shader programs and hot-reloads them when their sources change.
+
+	Watcher
+		A background thread watches the shader directory (inotify on Linux,
+		timestamp polling elsewhere) and queues the paths of modified files.
+
+	Rebuild
+		Update() runs on the render thread: changed programs are compiled and
+		linked into a new program object. With GL_KHR_parallel_shader_compile
+		the link is polled with GL_COMPLETION_STATUS_KHR instead of blocking.
+		The live program id is swapped only after the new program linked, so a
+		broken edit keeps the previous program running.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+#include "Graphics/Shader.h"
+
+class ShaderLibrary
+{
+public:
+	ShaderLibrary(const std::string& directory = "res/shaders");
+	~ShaderLibrary();
+
+public:
+	std::shared_ptr<Shader> Load(const std::string& name, const std::string& vertex_path, const std::string& fragment_path);
+	std::shared_ptr<Shader> Get(const std::string& name) const;
+
+	// Call once per frame on the render thread
+	void Update();
+
+	void SetHotReload(bool enable);
+
+private:
+	struct PendingBuild
+	{
+		std::shared_ptr<Shader> shader;
+		u32 program  = 0;
+		u32 vertex   = 0;
+		u32 fragment = 0;
+	};
+
+	void StartWatcher();
+	void StopWatcher();
+	void Watch();
+
+	void Rebuild(const std::shared_ptr<Shader>& shader);
+	bool Poll(PendingBuild& build);
+	void Abandon(PendingBuild& build);
+
+	static std::string Normalize(const std::filesystem::path& path);
+
+private:
+	std::filesystem::path m_directory;
+	std::unordered_map<std::string, std::shared_ptr<Shader>> m_shaders;
+	std::vector<PendingBuild> m_pending;
+
+	// Watcher thread
+	std::thread m_watcher;
+	std::atomic<bool> m_running = false;
+	std::mutex m_mutex;
+	std::vector<std::string> m_changed;
+	std::vector<std::string> m_watched_files;
+	bool m_hot_reload = true;
+
+	// GL_KHR_parallel_shader_compile
+	bool m_parallel_compile = false;
+};
@@ -16,6 +16,7 @@ Texture::Texture(const std::string& filepath, bool flip_vertically, bool filtere
 
 Texture::~Texture()
 {
+    RenderState::ForgetTexture(m_id);
     glDeleteTextures(1, &m_id);
 }
 
@@ -38,7 +39,7 @@ bool Texture::LoadFromFile(const std::string& filepath, bool flip_vertically)
 void Texture::Create(int width, int height, const unsigned char* data, int channels, bool filtered, bool clamped, bool mipmap)
 {
     glGenTextures(1, &m_id);
-    glBindTexture(GL_TEXTURE_2D, m_id);
+    RenderState::BindTexture(0, m_id);
 
     GLenum format = GL_RGB;
     switch (channels)
@@ -57,19 +58,16 @@ void Texture::Create(int width, int height, const unsigned char* data, int chann
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,     clamped  ? GL_CLAMP_TO_EDGE : GL_REPEAT);
 
     if (mipmap) glGenerateMipmap(GL_TEXTURE_2D);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture::Bind(unsigned int slot) const
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, m_id);
+    RenderState::BindTexture(slot, m_id);
 }
 
-void Texture::Unbind() const
+void Texture::Unbind(unsigned int slot) const
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderState::BindTexture(slot, 0);
 }
 
 GLuint Texture::GetID() const { return m_id; }
@@ -6,6 +6,7 @@
 #include <glad/glad.h>
 
 #include "Core/Common.h"
+#include "Graphics/RenderState.h"
 
 class Texture
 {
@@ -16,7 +17,7 @@ public:
 
 public:
 	void Bind(unsigned int slot = 0) const;
-	void Unbind() const;
+	void Unbind(unsigned int slot = 0) const;
 
 	GLuint GetID() const;
 	const std::string& GetPath() const;
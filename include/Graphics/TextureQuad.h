@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Core/Common.h"
+#include "Graphics/RenderState.h"
 
 struct TextureQuad
 {
@@ -34,7 +35,7 @@ struct TextureQuad
         glGenBuffers(1, &ebo);
 
         // Bind VAO
-        glBindVertexArray(vao);
+        RenderState::BindVertexArray(vao);
 
         // Bind and upload vertex data
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
@@ -57,11 +58,12 @@ struct TextureQuad
         glEnableVertexAttribArray(2);
 
         // Unbind VAO
-        glBindVertexArray(0);
+        RenderState::BindVertexArray(0);
     }
 
     ~TextureQuad()
     {
+        RenderState::ForgetVertexArray(vao);
         glDeleteVertexArrays(1, &vao);
         glDeleteBuffers(1, &vbo);
         glDeleteBuffers(1, &ebo);
@@ -69,9 +71,8 @@ struct TextureQuad
 
     void Draw()
     {
-        glBindVertexArray(vao);
+        RenderState::BindVertexArray(vao);
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
     }
 
     std::vector<vertex> vertices;
@@ -0,0 +1,79 @@
+/*
+	Uniform Buffer
+		A GL_UNIFORM_BUFFER mirroring a C++ struct, uploaded with a single
+		glBufferSubData. The struct must follow the std140 layout of the
+		matching block: vec4/mat4 aligned to 16 bytes, vec2 to 8, scalars to 4,
+		and no vec3 members (std140 pads them to 16 bytes).
+
+	Binding
+		The block name is registered with Shader, every program linked or
+		reloaded afterwards binds the block to the same binding point.
+*/
+#pragma once
+
+#include <string>
+
+#include <glad/glad.h>
+
+#include "Core/Common.h"
+#include "Graphics/Shader.h"
+
+// Binding points shared by all programs
+enum UniformBinding : u32
+{
+	FRAME_BINDING = 0, // FrameUniforms, updated by Application
+	USER_BINDING  = 1  // First binding point free for examples
+};
+
+// Per-frame data shared across programs as "layout(std140) uniform Frame"
+struct alignas(16) FrameUniforms
+{
+	mf4x4 proj_view  = mf4x4(1.0f);
+	mf4x4 view       = mf4x4(1.0f);
+	mf4x4 projection = mf4x4(1.0f);
+	vf4 camera       = vf4(0.0f);  // xyz: eye position
+	vf2 resolution   = vf2(0.0f);
+	f32 time         = 0.0f;
+	f32 delta_time   = 0.0f;
+};
+
+template <typename T>
+class UniformBuffer
+{
+public:
+	UniformBuffer(const std::string& block_name, u32 binding) : m_binding(binding)
+	{
+		static_assert(sizeof(T) % 16 == 0, "std140 block size must be a multiple of 16 bytes");
+
+		glGenBuffers(1, &m_id);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_id);
+
+		Shader::RegisterBlock(block_name, m_binding, sizeof(T));
+	}
+
+	~UniformBuffer()
+	{
+		glDeleteBuffers(1, &m_id);
+	}
+
+	UniformBuffer(const UniformBuffer&) = delete;
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+public:
+	void Upload(const T& data)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	u32 GetID() const { return m_id; }
+	u32 GetBinding() const { return m_binding; }
+
+private:
+	u32 m_id = 0;
+	u32 m_binding = 0;
+};
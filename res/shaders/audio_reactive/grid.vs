@@ -8,69 +8,30 @@ out vec4 Color;
 out vec3 FragPos;
 out vec3 Normal;
 
-uniform float t;
-uniform vec3  audio;
-uniform mat4  proj_view;
-uniform vec4  col;
-
-vec3 compute_height_field(vec3 pos)
+layout (std140) uniform Frame
 {
-    float height = 0.0;
-    
-    // Layer 1: Sub-bass - Very large, slow undulations (foundation)
-    float subBass = sin(pos.x * 0.15 + t * 0.8) * cos(pos.z * 0.15 - t * 0.6) * audio.x * 12.0;
-    height += subBass;
-    
-    // Layer 2: Bass - Smooth traveling waves
-    float bassWave = sin((pos.z - t * 2.0) * 0.8) * sin(pos.x * 0.3) * audio.x * 6.0;
-    height += bassWave;
-    
-    // Layer 3: Low-mid - Rolling hills effect
-    float lowMid = sin(pos.x * 0.5 + pos.z * 0.3 - t * 2.5) * cos(pos.x * 0.3 - pos.z * 0.5 + t * 1.8) * audio.y * 5.0;
-    height += lowMid;
-    
-    // Layer 4: Mid - Diagonal wave pattern
-    float midWave = sin((pos.x + pos.z) * 0.9 - t * 3.5) * cos((pos.x - pos.z) * 0.5 + t * 2.0) * audio.y * 4.0;
-    height += midWave;
-    
-    // Layer 5: High-mid - Circular ripples from center
-    float dist = length(pos.xz * 0.2);
-    float highMid = sin(dist * 5.0 - t * 4.0 + audio.z * 3.0) * audio.z * 2.0;
-    height += highMid;
-    
-    // Layer 6: Treble - Fast surface ripples
-    float trebleWave = sin(pos.x * 3.0 - t * 5.0) * cos(pos.z * 3.0 + t * 4.0) * audio.z * 2.0;
-    height += trebleWave;
-    
-    // Layer 7: High frequency detail - Fine texture
-    float detail = sin(pos.x * 5.0 + t * 6.0) * sin(pos.z * 4.5 - t * 5.5) * audio.z * 1.0;
-    height += detail;
-    
-    // Layer 8: Interference pattern - Cross waves
-    float interference = sin(pos.x * 1.2 - t * 3.2) * sin(pos.z * 1.3 + t * 2.8) * (audio.x + audio.y) * 1.2;
-    height += interference;
-    
-    // Layer 9: Smooth baseline undulation (always present)
-    float baseline = sin(pos.x * 0.2 + t * 0.5) * cos(pos.z * 0.2 - t * 0.3) * 1.2;
-    height += baseline;
-    
-    // Layer 10: Audio-reactive turbulence
-    float turbulence = sin(pos.x * 0.8 + sin(t * 1.5) * 2.0) * cos(pos.z * 0.7 + cos(t * 1.3) * 2.0) * (audio.x + audio.y + audio.z) * 0.6;
-    height += turbulence;
-    
-    pos.y += height;
-    return pos;
-}
-
+    mat4  proj_view;
+    mat4  view;
+    mat4  projection;
+    vec4  camera;
+    vec2  resolution;
+    float time;
+    float delta_time;
+};
 
+uniform sampler2D height_field; // xyz normal, w height, one texel per vertex
+uniform vec4  col;
 
 void main()
 {
-    // Audio-reactive height
-    vec3 pos = vec3(aPos.x, aPos.z, aPos.y);
-    pos      = compute_height_field(pos);
+    // Vertex (x, y) of the grid reads texel (x, y)
+    ivec2 texel = ivec2(aTexCoords * vec2(textureSize(height_field, 0) - 1) + 0.5);
+    vec4  field = texelFetch(height_field, texel, 0);
+
+    vec3 pos = vec3(aPos.x, field.w, aPos.y);
 
     Color    = col;
     FragPos  = pos;
+    Normal   = field.xyz;
     gl_Position = proj_view * vec4(pos, 1.0);
-}
\ No newline at end of file
+}
@@ -0,0 +1,94 @@
+#version 330 core
+
+// One texel per grid vertex: xyz normal, w height
+out vec4 FragColor;
+
+layout (std140) uniform Frame
+{
+    mat4  proj_view;
+    mat4  view;
+    mat4  projection;
+    vec4  camera;
+    vec2  resolution;
+    float time;
+    float delta_time;
+};
+
+uniform vec3  audio;
+uniform vec2  beat; // phase [0, 1) with 0 on the beat, confidence
+uniform vec4  extent; // xy world xz of texel (0, 0), zw world step between texels
+
+uniform sampler2D history;    // Mel spectrum per hop, rows wrap around
+uniform vec2  history_newest; // (row + 0.5) / rows, 1 / rows
+uniform float waterfall;      // Weight of the spectrogram terrain
+
+float compute_height(vec3 pos)
+{
+    float height = 0.0;
+    
+    // Layer 1: Sub-bass - Very large, slow undulations (foundation)
+    float subBass = sin(pos.x * 0.15 + time * 0.8) * cos(pos.z * 0.15 - time * 0.6) * audio.x * 12.0;
+    height += subBass;
+    
+    // Layer 2: Bass - Smooth traveling waves
+    float bassWave = sin((pos.z - time * 2.0) * 0.8) * sin(pos.x * 0.3) * audio.x * 6.0;
+    height += bassWave;
+    
+    // Layer 3: Low-mid - Rolling hills effect
+    float lowMid = sin(pos.x * 0.5 + pos.z * 0.3 - time * 2.5) * cos(pos.x * 0.3 - pos.z * 0.5 + time * 1.8) * audio.y * 5.0;
+    height += lowMid;
+    
+    // Layer 4: Mid - Diagonal wave pattern
+    float midWave = sin((pos.x + pos.z) * 0.9 - time * 3.5) * cos((pos.x - pos.z) * 0.5 + time * 2.0) * audio.y * 4.0;
+    height += midWave;
+    
+    // Layer 5: High-mid - Circular ripples from center
+    float dist = length(pos.xz * 0.2);
+    float highMid = sin(dist * 5.0 - time * 4.0 + audio.z * 3.0) * audio.z * 2.0;
+    height += highMid;
+    
+    // Layer 6: Treble - Fast surface ripples
+    float trebleWave = sin(pos.x * 3.0 - time * 5.0) * cos(pos.z * 3.0 + time * 4.0) * audio.z * 2.0;
+    height += trebleWave;
+    
+    // Layer 7: High frequency detail - Fine texture
+    float detail = sin(pos.x * 5.0 + time * 6.0) * sin(pos.z * 4.5 - time * 5.5) * audio.z * 1.0;
+    height += detail;
+    
+    // Layer 8: Interference pattern - Cross waves
+    float interference = sin(pos.x * 1.2 - time * 3.2) * sin(pos.z * 1.3 + time * 2.8) * (audio.x + audio.y) * 1.2;
+    height += interference;
+    
+    // Layer 9: Smooth baseline undulation (always present)
+    float baseline = sin(pos.x * 0.2 + time * 0.5) * cos(pos.z * 0.2 - time * 0.3) * 1.2;
+    height += baseline;
+    
+    // Layer 10: Audio-reactive turbulence
+    float turbulence = sin(pos.x * 0.8 + sin(time * 1.5) * 2.0) * cos(pos.z * 0.7 + cos(time * 1.3) * 2.0) * (audio.x + audio.y + audio.z) * 0.6;
+    height += turbulence;
+    
+    // Layer 11: Beat - Ring leaving the center on every beat
+    float ring = exp(-pow(dist - beat.x * 8.0, 2.0) * 4.0) * (1.0 - beat.x) * beat.y * 3.0;
+    height += ring;
+    
+    // Layer 12: Waterfall - Mel spectrum history, newest row on the far edge
+    vec2  uv  = (pos.xz - extent.xy) / (-2.0 * extent.xy);
+    float age = uv.y * (1.0 / history_newest.y - 1.0);
+    float mel = texture(history, vec2(uv.x, history_newest.x - age * history_newest.y)).r;
+    height += log(1.0 + mel) * waterfall * 4.0;
+    
+    return height;
+}
+
+void main()
+{
+    vec2 p = extent.xy + (gl_FragCoord.xy - 0.5) * extent.zw;
+
+    // Forward differences one grid step along x and z
+    float h  = compute_height(vec3(p.x, 0.0, p.y));
+    float hx = compute_height(vec3(p.x + extent.z, 0.0, p.y));
+    float hz = compute_height(vec3(p.x, 0.0, p.y + extent.w));
+    vec3 normal = normalize(vec3((h - hx) * extent.w, extent.z * extent.w, (h - hz) * extent.z));
+
+    FragColor = vec4(normal, h);
+}
@@ -0,0 +1,165 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 TexCoords;
+
+uniform vec2  screen_size;
+uniform int   max_iter;
+uniform bool  show_julia;
+
+// Reference orbit Z_n, ORBIT_WIDTH entries per row
+uniform sampler2D orbit;
+uniform int   orbit_length;
+
+// Pixel offset from the reference is 2^scale_exp * (offset + ndc * view)
+uniform int   scale_exp;
+uniform vec2  offset;
+uniform float view;
+
+// delta at series_skip = a u + b u^2 + c u^3, mantissas times 2^series_exp
+uniform int   series_skip;
+uniform vec2  series_a;
+uniform vec2  series_b;
+uniform vec2  series_c;
+uniform int   series_exp[3];
+
+const int   ORBIT_WIDTH = 4096;
+const int   FLOAT_EXP   = -60;   // delta leaves the rescaled form above 2^FLOAT_EXP
+const float BAILOUT     = 32.0;
+
+// from Mattz
+vec3 magma(float t)
+{
+    const vec3 c0 = vec3(-0.002136485053939582, -0.000749655052795221, -0.005386127855323933);
+    const vec3 c1 = vec3(0.2516605407371642,     0.6775232436837668,    2.494026599312351);
+    const vec3 c2 = vec3(8.353717279216625,     -3.577719514958484,     0.3144679030132573);
+    const vec3 c3 = vec3(-27.66873308576866,    14.26473078096533,    -13.64921318813922);
+    const vec3 c4 = vec3(52.17613981234068,    -27.94360607168351,     12.94416944238394);
+    const vec3 c5 = vec3(-50.76852536473588,    29.04658282127291,      4.23415299384598);
+    const vec3 c6 = vec3(18.65570506591883,    -11.48977351997711,    -5.601961508734096);
+    t *= 2.0; if (t >= 1.0) { t = 2.0 - t; }
+    return c0 + t * (c1 + t * ( c2 + t * (c3 + t * (c4 + t *(c5 + t * c6)))));
+}
+
+vec2 cmul(vec2 a, vec2 b)
+{
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+vec2 reference(int n)
+{
+    return texelFetch(orbit, ivec2(n % ORBIT_WIDTH, n / ORBIT_WIDTH), 0).xy;
+}
+
+float deep_fractal(vec2 u)
+{
+    // delta = d * 2^k while rescaled
+    vec2 d = show_julia ? u : vec2(0.0);
+    int  k = scale_exp;
+    int  n = 0;
+    int  m = 0;
+
+    if (series_skip > 0)
+    {
+        vec2 u2 = cmul(u, u);
+        int  e  = max(series_exp[0], max(series_exp[1], series_exp[2]));
+        d = cmul(series_a, u)              * exp2(float(series_exp[0] - e))
+          + cmul(series_b, u2)             * exp2(float(series_exp[1] - e))
+          + cmul(series_c, cmul(u2, u))    * exp2(float(series_exp[2] - e));
+        k = e;
+        n = series_skip;
+        m = series_skip;
+    }
+
+    float dc_scale = show_julia ? 0.0 : 1.0;
+    vec2  z = reference(m);
+    vec2  delta = vec2(0.0);
+    bool  rescaled = k < FLOAT_EXP;
+    if (!rescaled)
+    {
+        delta = d * exp2(float(k));
+        z += delta;
+    }
+
+    // Z_0 is 0 for Mandelbrot, z_0 of the reference for Julia
+    vec2 start = reference(0);
+
+    // The skipped prefix may already have left the bailout
+    int iter = max_iter;
+    if (dot(z, z) > BAILOUT)
+    {
+        iter = n;
+        n = max_iter;
+    }
+
+    for (; n < max_iter; n++)
+    {
+        vec2 Z = reference(m);
+        if (rescaled)
+        {
+            // The square term is 2^k below the mantissa, far under float precision
+            d = 2.0 * cmul(Z, d) + u * (dc_scale * exp2(float(scale_exp - k)));
+            m++;
+
+            // Keep the mantissa near 1
+            float mag = max(abs(d.x), abs(d.y));
+            if (mag > 65536.0 || (mag < 1.0 / 65536.0 && mag > 0.0))
+            {
+                int s = int(floor(log2(mag)));
+                d *= exp2(float(-s));
+                k += s;
+            }
+
+            z = reference(m);
+            if (dot(z, z) > BAILOUT)
+            {
+                iter = n + 1;
+                break;
+            }
+
+            if (k >= FLOAT_EXP)
+            {
+                rescaled = false;
+                delta = d * exp2(float(k));
+            }
+        }
+        else
+        {
+            delta = 2.0 * cmul(Z, delta) + cmul(delta, delta) + u * (dc_scale * exp2(float(scale_exp)));
+            m++;
+
+            z = reference(m) + delta;
+            if (dot(z, z) > BAILOUT)
+            {
+                iter = n + 1;
+                break;
+            }
+
+            // Rebase onto the orbit start when closer to it than to the reference
+            vec2 rebased = z - start;
+            if (dot(rebased, rebased) < dot(delta, delta) || m >= orbit_length - 1)
+            {
+                delta = rebased;
+                m = 0;
+            }
+        }
+    }
+
+    // Lower color banding
+    float smooth_iter = float(iter);
+    if (iter < max_iter)
+    {
+        float abs_z = max(dot(z, z), 1e-8);
+        smooth_iter = float(iter) + 1.0 - log2(log2(sqrt(abs_z)));
+    }
+    return smooth_iter / float(max_iter);
+}
+
+void main()
+{
+    float aspect_ratio = screen_size.x / screen_size.y;
+    vec2 ndc = (TexCoords - 0.5) * 2.0 * vec2(aspect_ratio, 1.0);
+
+    float t = deep_fractal(offset + ndc * view);
+    FragColor = vec4(magma(t), 1.0);
+}
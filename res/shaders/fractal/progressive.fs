@@ -0,0 +1,27 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 TexCoords;
+
+// Coarse to fine, alpha 0 where a level has not been drawn yet
+uniform sampler2D level0;
+uniform sampler2D level1;
+uniform sampler2D level2;
+
+vec4 fetch(sampler2D level)
+{
+    ivec2 size = textureSize(level, 0);
+    ivec2 texel = min(ivec2(TexCoords * vec2(size)), size - 1);
+    return texelFetch(level, texel, 0);
+}
+
+void main()
+{
+    vec4 color = fetch(level2);
+    if (color.a == 0.0)
+        color = fetch(level1);
+    if (color.a == 0.0)
+        color = fetch(level0);
+
+    FragColor = vec4(color.rgb, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D previous;
+uniform vec2 shift; // whole pixels the view moved
+
+void main()
+{
+    ivec2 source = ivec2(gl_FragCoord.xy) + ivec2(shift);
+    ivec2 size = textureSize(previous, 0);
+
+    // Uncovered pixels are empty until a tile draws them
+    if (any(lessThan(source, ivec2(0))) || any(greaterThanEqual(source, size)))
+        FragColor = vec4(0.0);
+    else
+        FragColor = texelFetch(previous, source, 0);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screen_texture;
+uniform sampler2D bloom_texture;
+uniform float intensity;
+
+void main()
+{
+    vec3 color = texture(screen_texture, TexCoords).rgb + texture(bloom_texture, TexCoords).rgb * intensity;
+    FragColor = vec4(color, 1.0);
+}
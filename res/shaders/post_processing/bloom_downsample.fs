@@ -0,0 +1,55 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screen_texture;
+uniform vec2 texel_size; // Texel of the input level
+
+// Bright pass, only on the first level
+uniform int   prefilter;
+uniform float threshold;
+uniform float knee;
+
+// Soft knee threshold, keeps the bloom from popping at the cutoff
+vec3 Prefilter(vec3 c)
+{
+    float brightness = max(c.r, max(c.g, c.b));
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 1e-4);
+    float contribution = max(soft, brightness - threshold) / max(brightness, 1e-4);
+    return c * contribution;
+}
+
+// 13 tap downsample: five overlapping 2x2 boxes, each tap is a bilinear fetch
+vec3 Downsample(vec2 uv)
+{
+    vec2 t = texel_size;
+    vec3 a = texture(screen_texture, uv + t * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(screen_texture, uv + t * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(screen_texture, uv + t * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(screen_texture, uv + t * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(screen_texture, uv).rgb;
+    vec3 f = texture(screen_texture, uv + t * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(screen_texture, uv + t * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(screen_texture, uv + t * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(screen_texture, uv + t * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(screen_texture, uv + t * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(screen_texture, uv + t * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(screen_texture, uv + t * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(screen_texture, uv + t * vec2( 1.0, -1.0)).rgb;
+
+    return e * 0.125
+         + (a + c + g + i) * 0.03125
+         + (b + d + f + h) * 0.0625
+         + (j + k + l + m) * 0.125;
+}
+
+void main()
+{
+    vec3 color = Downsample(TexCoords);
+    if (prefilter != 0)
+        color = Prefilter(color);
+    FragColor = vec4(color, 1.0);
+}
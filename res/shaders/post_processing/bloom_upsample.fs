@@ -0,0 +1,31 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D low_texture;     // Previous, smaller level of the upsample chain
+uniform sampler2D current_texture; // Downsample level of the same size as the output
+uniform vec2 texel_size;           // Texel of low_texture
+uniform float radius;              // Tent radius in texels
+
+// 3x3 tent filter, (1 2 1) x (1 2 1) / 16
+vec3 Tent(vec2 uv)
+{
+    vec2 t = texel_size * radius;
+    vec3 sum = texture(low_texture, uv).rgb * 4.0;
+    sum += (texture(low_texture, uv + vec2(-t.x, 0.0)).rgb +
+            texture(low_texture, uv + vec2( t.x, 0.0)).rgb +
+            texture(low_texture, uv + vec2(0.0, -t.y)).rgb +
+            texture(low_texture, uv + vec2(0.0,  t.y)).rgb) * 2.0;
+    sum +=  texture(low_texture, uv + vec2(-t.x, -t.y)).rgb +
+            texture(low_texture, uv + vec2( t.x, -t.y)).rgb +
+            texture(low_texture, uv + vec2(-t.x,  t.y)).rgb +
+            texture(low_texture, uv + vec2( t.x,  t.y)).rgb;
+    return sum / 16.0;
+}
+
+void main()
+{
+    FragColor = vec4(Tent(TexCoords) + texture(current_texture, TexCoords).rgb, 1.0);
+}
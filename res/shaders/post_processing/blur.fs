@@ -0,0 +1,19 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screen_texture;
+uniform vec2 direction; // Step between taps in uv, (radius, 0) or (0, radius)
+
+// One axis of the 3x3 kernel (1 2 1) x (1 2 1) / 16, run twice
+const float weight[3] = float[](0.25, 0.5, 0.25);
+
+void main()
+{
+    vec3 sum = vec3(0.0);
+    for (int i = -1; i <= 1; i++)
+        sum += texture(screen_texture, TexCoords + float(i) * direction).rgb * weight[i + 1];
+    FragColor = vec4(sum, 1.0);
+}
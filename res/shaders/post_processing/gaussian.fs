@@ -0,0 +1,25 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screen_texture;
+uniform vec2 texel_size;
+uniform vec2 direction; // (1, 0) or (0, 1)
+
+// 9 tap Gaussian in 5 fetches, neighbouring taps merged into one bilinear fetch
+const float offset[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weight[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main()
+{
+    vec2 step = direction * texel_size;
+    vec3 sum = texture(screen_texture, TexCoords).rgb * weight[0];
+    for (int i = 1; i < 3; i++)
+    {
+        sum += texture(screen_texture, TexCoords + step * offset[i]).rgb * weight[i];
+        sum += texture(screen_texture, TexCoords - step * offset[i]).rgb * weight[i];
+    }
+    FragColor = vec4(sum, 1.0);
+}
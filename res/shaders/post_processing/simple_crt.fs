@@ -6,58 +6,46 @@ in vec2 TexCoords;
 out vec4 FragColor;
 
 uniform sampler2D screen_texture;
-uniform vec2 screen_resolution;
-
-// Scanline
-uniform float scanline_amplitude;
-uniform float scanline_frequency;
-uniform float scanline_offset;
-
-// Phosphor dot
-uniform float phosphor_dot_scale;     // How many dot cells per unit; e.g. 640.0 for high-res CRT dots
-uniform float phosphor_dot_softness;  // Controls softness of dot edges, e.g., 0.15
-
-// Barrel Distortion 
-uniform float primary_curvature;
-uniform float secondary_curvature;
-
-// Vignette
-uniform float vignette_radius;   // Radius where the vignette effect starts
-uniform float vignette_softness; // Controls the softness of the vignette transition
-
-// Gaussian Blur
-uniform float blur_radius;  // Controls how far to sample (e.g., 1.0/textureWidth)
-uniform float blend_factor; // How much of the blur to mix in (0.0 to 1.0)
-
-// Gaussian kernel
-const float kernel[9] = float[](
-    0.0625, 0.125, 0.0625,
-    0.125,  0.25,  0.125,
-    0.0625, 0.125, 0.0625
-);
-
-// Color Correction
-uniform float gamma;
-uniform float contrast;
-uniform float saturation;
-uniform float brightness;
-uniform float color_correction;
-
-vec3 GaussianBlur(vec2 uv) 
+uniform sampler2D blur_texture;  // screen_texture after the separable blur passes
+uniform sampler2D bloom_texture; // Thresholded bloom pyramid at half resolution
+// Filled from the C++ SimpleCRTConfig struct with a single upload, member order must match
+layout (std140) uniform SimpleCRTConfig
 {
-    vec3 sum = vec3(0.0);
-    int index = 0;
-    for (int y = -1; y <= 1; y++) 
-    {
-        for (int x = -1; x <= 1; x++) 
-        {
-            vec2 offset = vec2(float(x), float(y)) * blur_radius;
-            sum += texture(screen_texture, uv + offset).rgb * kernel[index];
-            index++;
-        }
-    }
-    return sum;
-}
+    vec2 screen_resolution;
+
+    // Scanline
+    float scanline_amplitude;
+    float scanline_frequency;
+    float scanline_offset;
+
+    // Barrel Distortion 
+    float primary_curvature;
+    float secondary_curvature;
+
+    // Vignette
+    float vignette_radius;   // Radius where the vignette effect starts
+    float vignette_softness; // Controls the softness of the vignette transition
+
+    // Gaussian Blur
+    float blur_radius;  // Controls how far to sample (e.g., 1.0/textureWidth)
+    float blend_factor; // How much of the blur to mix in (0.0 to 1.0)
+
+    // Color Correction
+    float gamma;
+    float contrast;
+    float saturation;
+    float brightness;
+    float color_correction;
+
+    // Phosphor dot
+    float phosphor_dot_scale;     // How many dot cells per unit; e.g. 640.0 for high-res CRT dots
+    float phosphor_dot_softness;  // Controls softness of dot edges, e.g., 0.15
+
+    // Bloom
+    float bloom_intensity;    // How strong the bloom is added
+    float bloom_threshold;    // Luminance threshold for bloom extraction
+    float bloom_blend_factor; // Controls blending (blurred vs. raw bright pass)
+};
 
 vec2 BarrelDistort(vec2 uv, float k1, float k2) 
 {
@@ -75,11 +63,6 @@ vec3 PostEffects(in vec3 rgb)
     return rgb;
 }
 
-// Bloom
-uniform float bloom_intensity;    // How strong the bloom is added
-uniform float bloom_threshold;    // Luminance threshold for bloom extraction
-uniform float bloom_blend_factor; // Controls blending (blurred vs. raw bright pass)
-
 void main() 
 {
     // Extract uv coordinates
@@ -90,7 +73,7 @@ void main()
 
     // Color bleeding
     vec3 original_color = texture(screen_texture, uv).rgb; // Extract color from screen texture
-    vec3 blurred_color  = GaussianBlur(uv);
+    vec3 blurred_color  = texture(blur_texture, uv).rgb;
     vec3 gauss_mix      = mix(original_color, blurred_color, blend_factor); // Blend the blurred color with the original color.
     
     vec3 final_color = gauss_mix;
@@ -121,8 +104,8 @@ void main()
     float luminance = dot(scene_color, vec3(0.2126, 0.7152, 0.0722));
     // Extract bright parts (only pixels above bloom_threshold contribute)
     vec3 brightPass = scene_color * step(bloom_threshold, luminance);
-    // Apply a basic blur to the bright parts (again, using the GaussianBlur function)
-    vec3 blurredBright = GaussianBlur(uv);
+    // Wide blur of the bright parts from the bloom pyramid
+    vec3 blurredBright = texture(bloom_texture, uv).rgb;
     // Blend the raw bright pass with its blurred version to get a smoother bloom.
     vec3 bloom_effect = mix(brightPass, blurredBright, bloom_blend_factor);
     // Add the bloom effect on top of the CRT effect.
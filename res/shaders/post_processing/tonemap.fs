@@ -0,0 +1,17 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screen_texture; // HDR scene
+uniform float exposure;
+
+void main()
+{
+    vec3 hdr = texture(screen_texture, TexCoords).rgb;
+
+    // Exponential tone curve, linear near black and saturating smoothly above 1
+    vec3 color = vec3(1.0) - exp(-hdr * exposure);
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screen_texture; // Scene at render scale
+uniform vec2 texel_size;          // Texel of screen_texture
+uniform float sharpness;          // 0 bilinear, 1 strong
+
+// Bilinear upscale plus an unsharp mask over the cross neighbours, clamped to
+// the neighbourhood range so edges do not ring
+void main()
+{
+    vec3 center = texture(screen_texture, TexCoords).rgb;
+    vec3 n = texture(screen_texture, TexCoords + vec2(0.0,  texel_size.y)).rgb;
+    vec3 s = texture(screen_texture, TexCoords - vec2(0.0,  texel_size.y)).rgb;
+    vec3 e = texture(screen_texture, TexCoords + vec2(texel_size.x, 0.0)).rgb;
+    vec3 w = texture(screen_texture, TexCoords - vec2(texel_size.x, 0.0)).rgb;
+
+    vec3 lo = min(center, min(min(n, s), min(e, w)));
+    vec3 hi = max(center, max(max(n, s), max(e, w)));
+
+    vec3 sharpened = center + (4.0 * center - (n + s + e + w)) * 0.25 * sharpness;
+    FragColor = vec4(clamp(sharpened, lo, hi), 1.0);
+}